@@ -15,14 +15,19 @@
 
 
 
-#include <sys/time.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <errno.h>
 #include <libintl.h>
 #include <System.h>
 #include <gtk/gtk.h>
+#include "drift.h"
+#include "engine.h"
+#include "parser.h"
+#include "search.h"
+#include "shared.h"
+#include "source.h"
 #include "clock.h"
 #define _(string) gettext(string)
 
@@ -30,15 +35,40 @@
 /* Clock */
 /* private */
 /* types */
+typedef struct _ClockRow
+{
+	gboolean timer;
+	GtkTreeIter iter;
+	/* upcoming */
+	gboolean upcoming;
+	GtkTreeIter up_iter;
+} ClockRow;
+
 struct _Clock
 {
 	/* internal */
+	ClockSource * clocksource;
 	guint source;
 
+	/* scheduler */
+	ClockEngine * engine;
+	guint sc_source;
+	unsigned int sc_id;
+	GHashTable * sc_rows;
+	int64_t sc_start;
+	uint64_t sc_ticks;
+
+	/* shared */
+	ClockShared * shared;
+	guint sh_source;
+	long sh_gmtoff;
+
 	/* widgets */
 	GtkWidget * window;
 	/* alarms */
+	ClockSearch * al_search;
 	GtkListStore * al_store;
+	GtkTreeModel * al_filter;
 	GtkWidget * al_view;
 	/* clock */
 	GtkWidget * cl_toggle;
@@ -48,8 +78,20 @@ struct _Clock
 	GtkWidget * cl_hour;
 	GtkWidget * cl_minute;
 	GtkWidget * cl_second;
+	GtkWidget * cl_wakeups;
+	/* drift */
+	ClockDrift * drift;
+	guint dr_source;
+	GtkWidget * dr_area;
+	GtkWidget * dr_label;
+	/* upcoming */
+	GtkListStore * up_store;
+	GtkWidget * up_view;
+	int64_t up_now;
 	/* timers */
+	ClockSearch * ti_search;
 	GtkListStore * ti_store;
+	GtkTreeModel * ti_filter;
 	GtkWidget * ti_view;
 	/* actions */
 	GtkWidget * apply;
@@ -59,41 +101,110 @@ typedef enum _ClockAlarmColumn
 {
 	CAC_ACTIVE = 0,
 	CAC_TITLE,
-	CAC_TIME
+	CAC_TIME,
+	CAC_ID,
+	CAC_SECONDS,
+	CAC_TOLERANCE,
+	CAC_WHEN
 } ClockAlarmColumn;
-#define CAC_LAST CAC_TIME
+#define CAC_LAST CAC_WHEN
 #define CAC_COUNT (CAC_LAST + 1)
 
 typedef enum _ClockTimerColumn
 {
 	CTC_ACTIVE = 0,
 	CTC_TITLE,
-	CTC_TIME
+	CTC_TIME,
+	CTC_ID,
+	CTC_SECONDS,
+	CTC_TOLERANCE
 } ClockTimerColumn;
-#define CTC_LAST CTC_TIME
+#define CTC_LAST CTC_TOLERANCE
 #define CTC_COUNT (CTC_LAST + 1)
 
+typedef enum _ClockUpcomingColumn
+{
+	CUC_ID = 0,
+	CUC_TITLE,
+	CUC_TYPE,
+	CUC_DEADLINE
+} ClockUpcomingColumn;
+#define CUC_LAST CUC_DEADLINE
+#define CUC_COUNT (CUC_LAST + 1)
+
+
+/* constants */
+#define CLOCK_ALARM_TOLERANCE	60
+#define CLOCK_TIMER_TOLERANCE	1
+
 
 /* prototypes */
+/* accessors */
+static gboolean _clock_get_iter(GtkTreeModel * filter, GtkTreeIter * iter,
+		gchar const * path);
+
 /* useful */
 static int _clock_error(Clock * clock, char const * message, int ret);
+static void _clock_notify(Clock * clock, char const * title,
+		char const * message);
+
+static void _clock_alarm_schedule(Clock * clock, GtkTreeIter * iter);
+static void _clock_schedule(Clock * clock);
+static void _clock_search(Clock * clock, ClockSearch * search,
+		GtkListStore * store, GtkTreeModel * filter, GtkWidget * view,
+		char const * query);
+static void _clock_share(Clock * clock);
+static void _clock_timer_schedule(Clock * clock, GtkTreeIter * iter);
+static void _clock_upcoming(Clock * clock, unsigned int id);
+static void _clock_wakeups(Clock * clock);
 
 /* callbacks */
 static void _clock_on_apply(gpointer data);
 static void _clock_on_close(gpointer data);
+static gboolean _clock_on_share(gpointer data);
 static gboolean _clock_on_timeout(gpointer data);
 static void _clock_on_toggled(gpointer data);
 static gboolean _clock_on_window_closex(gpointer data);
 
+/* drift */
+static gboolean _clock_on_drift(gpointer data);
+#if GTK_CHECK_VERSION(3, 0, 0)
+static gboolean _clock_on_drift_draw(GtkWidget * widget, cairo_t * cairo,
+		gpointer data);
+#else
+static gboolean _clock_on_drift_expose(GtkWidget * widget,
+		GdkEventExpose * event, gpointer data);
+#endif
+
+/* scheduler */
+static gboolean _clock_on_schedule(gpointer data);
+static void _clock_on_schedule_event(void * data, unsigned int id,
+		ClockEngineEvent event, int64_t deadline, int64_t now);
+
 /* alarm */
 static void _clock_on_alarm_delete(gpointer data);
+static void _clock_on_alarm_search(GtkEntry * entry, gpointer data);
 static void _clock_on_alarm_toggled(GtkCellRendererToggle * renderer,
 		char * path, gpointer data);
+static void _clock_on_alarm_tolerance_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data);
+static gboolean _clock_on_alarm_visible(GtkTreeModel * model,
+		GtkTreeIter * iter, gpointer data);
 
 /* timer */
 static void _clock_on_timer_delete(gpointer data);
+static void _clock_on_timer_search(GtkEntry * entry, gpointer data);
 static void _clock_on_timer_toggled(GtkCellRendererToggle * renderer,
 		char * path, gpointer data);
+static void _clock_on_timer_tolerance_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data);
+static gboolean _clock_on_timer_visible(GtkTreeModel * model,
+		GtkTreeIter * iter, gpointer data);
+
+/* upcoming */
+static void _clock_on_upcoming_countdown(GtkTreeViewColumn * column,
+		GtkCellRenderer * renderer, GtkTreeModel * model,
+		GtkTreeIter * iter, gpointer data);
 
 
 /* public */
@@ -101,13 +212,30 @@ static void _clock_on_timer_toggled(GtkCellRendererToggle * renderer,
 /* clock_new */
 static void _new_alarms(Clock * clock, GtkWidget * notebook);
 static void _new_alarms_on_new(gpointer data);
+static void _new_alarms_on_time_changed(GtkEntry * entry);
+static void _new_alarms_on_time_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data);
+static void _new_alarms_on_time_editing_started(GtkCellRenderer * renderer,
+		GtkCellEditable * editable, gchar * path, gpointer data);
 static void _new_alarms_on_title_edited(GtkCellRendererText * renderer,
 		gchar * path, gchar * text, gpointer data);
 static void _new_date(Clock * clock, GtkWidget * notebook);
+static void _new_drift(Clock * clock, GtkWidget * vbox);
+static ClockDrift * _new_drift_open(void);
+static GtkWidget * _new_search(Clock * clock, GCallback callback);
+static GtkCellRenderer * _new_tolerance(void);
+static void _new_validate(GtkEntry * entry, gboolean valid);
 static void _new_timers(Clock * clock, GtkWidget * notebook);
 static void _new_timers_on_new(gpointer data);
+static void _new_timers_on_duration_changed(GtkEntry * entry);
+static void _new_timers_on_duration_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data);
+static void _new_timers_on_duration_editing_started(
+		GtkCellRenderer * renderer, GtkCellEditable * editable,
+		gchar * path, gpointer data);
 static void _new_timers_on_title_edited(GtkCellRendererText * renderer,
 		gchar * path, gchar * text, gpointer data);
+static void _new_upcoming(Clock * clock, GtkWidget * notebook);
 
 Clock * clock_new(void)
 {
@@ -118,6 +246,40 @@ Clock * clock_new(void)
 
 	if((clock = object_new(sizeof(*clock))) == NULL)
 		return NULL;
+	clock->al_search = clocksearch_new();
+	clock->ti_search = clocksearch_new();
+	clock->clocksource = clocksource_new();
+	clock->engine = (clock->clocksource != NULL) ? clockengine_new(
+			clock->clocksource, _clock_on_schedule_event, clock)
+		: NULL;
+	if(clock->engine == NULL
+			|| clock->al_search == NULL
+			|| clock->ti_search == NULL)
+	{
+		if(clock->engine != NULL)
+			clockengine_delete(clock->engine);
+		if(clock->clocksource != NULL)
+			clocksource_delete(clock->clocksource);
+		if(clock->ti_search != NULL)
+			clocksearch_delete(clock->ti_search);
+		if(clock->al_search != NULL)
+			clocksearch_delete(clock->al_search);
+		object_delete(clock);
+		return NULL;
+	}
+	clock->sc_source = 0;
+	clock->sc_id = 0;
+	clock->sc_rows = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+	clock->sc_start = clocksource_get_time(clock->clocksource);
+	clock->sc_ticks = 0;
+	clock->up_now = clock->sc_start;
+	/* optional */
+	clock->shared = clockshared_new(NULL);
+	clock->sh_source = 0;
+	clock->sh_gmtoff = 0;
+	clock->drift = _new_drift_open();
+	clock->dr_source = 0;
+	clockparser_init();
 	clock->window = gtk_dialog_new();
 	gtk_window_set_default_size(GTK_WINDOW(clock->window), 200, 300);
 #if GTK_CHECK_VERSION(2, 6, 0)
@@ -136,6 +298,7 @@ Clock * clock_new(void)
 	/* notebook */
 	widget = gtk_notebook_new();
 	_new_date(clock, widget);
+	_new_upcoming(clock, widget);
 	_new_alarms(clock, widget);
 	_new_timers(clock, widget);
 	gtk_box_pack_start(GTK_BOX(vbox), widget, TRUE, TRUE, 0);
@@ -154,8 +317,15 @@ Clock * clock_new(void)
 	g_signal_connect_swapped(widget, "clicked", G_CALLBACK(_clock_on_close),
 			clock);
 	gtk_container_add(GTK_CONTAINER(hbox), widget);
-	clock->source = g_timeout_add(1000, _clock_on_timeout, clock);
+	clock->source = g_timeout_add_seconds(1, _clock_on_timeout, clock);
 	_clock_on_timeout(clock);
+	_clock_share(clock);
+	if(clock->drift != NULL)
+	{
+		clock->dr_source = g_timeout_add_seconds(CLOCKDRIFT_INTERVAL,
+				_clock_on_drift, clock);
+		_clock_on_drift(clock);
+	}
 	gtk_widget_show_all(clock->window);
 	return clock;
 }
@@ -196,6 +366,9 @@ static void _new_alarms(Clock * clock, GtkWidget * notebook)
 				_clock_on_alarm_delete), clock);
 	gtk_toolbar_insert(GTK_TOOLBAR(widget), toolitem, -1);
 	gtk_box_pack_start(GTK_BOX(vbox), widget, FALSE, TRUE, 0);
+	/* search */
+	widget = _new_search(clock, G_CALLBACK(_clock_on_alarm_search));
+	gtk_box_pack_start(GTK_BOX(vbox), widget, FALSE, TRUE, 0);
 	/* view */
 	widget = gtk_scrolled_window_new(NULL, NULL);
 	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(widget),
@@ -203,9 +376,17 @@ static void _new_alarms(Clock * clock, GtkWidget * notebook)
 	clock->al_store = gtk_list_store_new(CAC_COUNT,
 			G_TYPE_BOOLEAN,		/* CAC_ACTIVE */
 			G_TYPE_STRING,		/* CAC_TITLE */
-			G_TYPE_STRING);		/* CAC_TIME */
-	clock->al_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(
-				clock->al_store));
+			G_TYPE_STRING,		/* CAC_TIME */
+			G_TYPE_UINT,		/* CAC_ID */
+			G_TYPE_INT,		/* CAC_SECONDS */
+			G_TYPE_UINT,		/* CAC_TOLERANCE */
+			G_TYPE_INT64);		/* CAC_WHEN */
+	clock->al_filter = gtk_tree_model_filter_new(GTK_TREE_MODEL(
+				clock->al_store), NULL);
+	gtk_tree_model_filter_set_visible_func(GTK_TREE_MODEL_FILTER(
+				clock->al_filter), _clock_on_alarm_visible,
+			clock, NULL);
+	clock->al_view = gtk_tree_view_new_with_model(clock->al_filter);
 	/* active */
 	renderer = gtk_cell_renderer_toggle_new();
 	g_signal_connect(renderer, "toggled", G_CALLBACK(
@@ -224,10 +405,21 @@ static void _new_alarms(Clock * clock, GtkWidget * notebook)
 	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->al_view), column);
 	/* time */
 	renderer = gtk_cell_renderer_text_new();
-	/* FIXME popup when editing */
+	g_object_set(G_OBJECT(renderer), "editable", TRUE, NULL);
+	g_signal_connect(renderer, "editing-started", G_CALLBACK(
+				_new_alarms_on_time_editing_started), clock);
+	g_signal_connect(renderer, "edited", G_CALLBACK(
+				_new_alarms_on_time_edited), clock);
 	column = gtk_tree_view_column_new_with_attributes(_("Time"), renderer,
 			"text", CAC_TIME, NULL);
 	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->al_view), column);
+	/* tolerance */
+	renderer = _new_tolerance();
+	g_signal_connect(renderer, "edited", G_CALLBACK(
+				_clock_on_alarm_tolerance_edited), clock);
+	column = gtk_tree_view_column_new_with_attributes(_("Tolerance"),
+			renderer, "text", CAC_TOLERANCE, NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->al_view), column);
 	gtk_container_add(GTK_CONTAINER(widget), clock->al_view);
 	gtk_box_pack_start(GTK_BOX(vbox), widget, TRUE, TRUE, 0);
 	gtk_notebook_append_page(GTK_NOTEBOOK(notebook), vbox,
@@ -235,26 +427,105 @@ static void _new_alarms(Clock * clock, GtkWidget * notebook)
 }
 
 static void _new_alarms_on_new(gpointer data)
+{
+	Clock * clock = data;
+	ClockRow * row;
+
+	/* index the title first for the filter to show the new row */
+	if(clocksearch_set(clock->al_search, ++clock->sc_id, _("Alarm")) != 0)
+	{
+		_clock_error(clock, error_get(NULL), 1);
+		return;
+	}
+	row = g_new(ClockRow, 1);
+	row->timer = FALSE;
+	row->upcoming = FALSE;
+	gtk_list_store_append(clock->al_store, &row->iter);
+	gtk_list_store_set(clock->al_store, &row->iter, CAC_ACTIVE, FALSE,
+			CAC_TITLE, _("Alarm"), CAC_ID, clock->sc_id,
+			CAC_SECONDS, -1, CAC_TOLERANCE, CLOCK_ALARM_TOLERANCE,
+			CAC_WHEN, (gint64)0, -1);
+	g_hash_table_insert(clock->sc_rows, GUINT_TO_POINTER(clock->sc_id),
+			row);
+}
+
+static void _new_alarms_on_time_changed(GtkEntry * entry)
+{
+	ClockParserTime t;
+
+	_new_validate(entry, clockparser_time(gtk_entry_get_text(entry), &t)
+			== 0);
+}
+
+static void _new_alarms_on_time_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data)
 {
 	Clock * clock = data;
 	GtkTreeIter iter;
+	ClockParserTime t;
+	char buf[CLOCKPARSER_SIZE];
+	int64_t when = 0;
+	struct tm tm;
+	(void) renderer;
 
-	gtk_list_store_append(clock->al_store, &iter);
-	gtk_list_store_set(clock->al_store, &iter, CAC_ACTIVE, FALSE,
-			CAC_TITLE, _("Alarm"), -1);
+	if(_clock_get_iter(clock->al_filter, &iter, path) != TRUE
+			|| clockparser_time(text, &t) != 0
+			|| clockparser_format_time(&t, buf, sizeof(buf)) == 0)
+		return;
+	/* alarms with a date only fire once */
+	if((t.flags & CPTF_DATE) && clockparser_time_to_utc(&t, &when) != 0)
+	{
+		memset(&tm, 0, sizeof(tm));
+		tm.tm_year = t.year - 1900;
+		tm.tm_mon = t.month - 1;
+		tm.tm_mday = t.day;
+		tm.tm_hour = t.hour;
+		tm.tm_min = t.minute;
+		tm.tm_sec = t.second;
+		tm.tm_isdst = -1;
+		if((when = clocksource_mktime(clock->clocksource, &tm)) < 0)
+			return;
+		when /= 1000;
+	}
+	gtk_list_store_set(clock->al_store, &iter, CAC_TIME, buf,
+			CAC_SECONDS, t.hour * 3600 + t.minute * 60 + t.second,
+			CAC_WHEN, (gint64)when, -1);
+	_clock_alarm_schedule(clock, &iter);
+}
+
+static void _new_alarms_on_time_editing_started(GtkCellRenderer * renderer,
+		GtkCellEditable * editable, gchar * path, gpointer data)
+{
+	(void) renderer;
+	(void) path;
+	(void) data;
+
+	if(!GTK_IS_ENTRY(editable))
+		return;
+	g_signal_connect(editable, "changed", G_CALLBACK(
+				_new_alarms_on_time_changed), NULL);
+	_new_alarms_on_time_changed(GTK_ENTRY(editable));
 }
 
 static void _new_alarms_on_title_edited(GtkCellRendererText * renderer,
 		gchar * path, gchar * text, gpointer data)
 {
 	Clock * clock = data;
-	GtkTreeModel * model = GTK_TREE_MODEL(clock->al_store);
 	GtkTreeIter iter;
+	guint id;
 	(void) renderer;
 
-	if(gtk_tree_model_get_iter_from_string(model, &iter, path) != TRUE)
+	if(_clock_get_iter(clock->al_filter, &iter, path) != TRUE)
 		return;
+	gtk_tree_model_get(GTK_TREE_MODEL(clock->al_store), &iter, CAC_ID, &id,
+			-1);
+	if(clocksearch_set(clock->al_search, id, text) != 0)
+	{
+		_clock_error(clock, error_get(NULL), 1);
+		return;
+	}
 	gtk_list_store_set(clock->al_store, &iter, CAC_TITLE, text, -1);
+	_clock_upcoming(clock, id);
 }
 
 static void _new_date(Clock * clock, GtkWidget * notebook)
@@ -343,12 +614,75 @@ static void _new_date(Clock * clock, GtkWidget * notebook)
 		gtk_box_pack_start(GTK_BOX(hbox), widget, TRUE, TRUE, 0);
 		gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, TRUE, 0);
 	}
+	/* wakeups */
+	clock->cl_wakeups = gtk_label_new(NULL);
+#if GTK_CHECK_VERSION(3, 0, 0)
+	g_object_set(clock->cl_wakeups, "halign", GTK_ALIGN_START, NULL);
+#else
+	gtk_misc_set_alignment(GTK_MISC(clock->cl_wakeups), 0.0, 0.5);
+#endif
+	gtk_box_pack_start(GTK_BOX(vbox), clock->cl_wakeups, FALSE, TRUE, 0);
 	/* automatic update */
 	/* FIXME add a button to start ntpdate? */
+	/* drift */
+	if(clock->drift != NULL)
+		_new_drift(clock, vbox);
 	gtk_notebook_append_page(GTK_NOTEBOOK(notebook), vbox,
 			gtk_label_new(_("Clock")));
 }
 
+static void _new_drift(Clock * clock, GtkWidget * vbox)
+{
+	GtkWidget * frame;
+	GtkWidget * widget;
+
+	frame = gtk_frame_new(_("Drift"));
+#if GTK_CHECK_VERSION(3, 0, 0)
+	widget = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
+#else
+	widget = gtk_vbox_new(FALSE, 4);
+#endif
+	gtk_container_set_border_width(GTK_CONTAINER(widget), 4);
+	/* sparkline */
+	clock->dr_area = gtk_drawing_area_new();
+	gtk_widget_set_size_request(clock->dr_area, -1, 48);
+#if GTK_CHECK_VERSION(3, 0, 0)
+	g_signal_connect(clock->dr_area, "draw", G_CALLBACK(
+				_clock_on_drift_draw), clock);
+#else
+	g_signal_connect(clock->dr_area, "expose-event", G_CALLBACK(
+				_clock_on_drift_expose), clock);
+#endif
+	gtk_box_pack_start(GTK_BOX(widget), clock->dr_area, TRUE, TRUE, 0);
+	/* label */
+	clock->dr_label = gtk_label_new(NULL);
+#if GTK_CHECK_VERSION(3, 0, 0)
+	g_object_set(clock->dr_label, "halign", GTK_ALIGN_START, NULL);
+#else
+	gtk_misc_set_alignment(GTK_MISC(clock->dr_label), 0.0, 0.5);
+#endif
+	gtk_box_pack_start(GTK_BOX(widget), clock->dr_label, FALSE, TRUE, 0);
+	gtk_container_add(GTK_CONTAINER(frame), widget);
+	gtk_box_pack_end(GTK_BOX(vbox), frame, TRUE, TRUE, 0);
+}
+
+static ClockDrift * _new_drift_open(void)
+{
+	ClockDrift * drift;
+	gchar * dirname;
+	gchar * filename;
+
+	dirname = g_build_filename(g_get_home_dir(), ".clock", NULL);
+	filename = g_build_filename(dirname, "drift", NULL);
+	if(g_mkdir_with_parents(dirname, 0700) != 0
+			|| (drift = clockdrift_new(filename)) == NULL)
+		/* fallback to a volatile ring, as when locked by another */
+		drift = clockdrift_new(NULL);
+	g_free(filename);
+	g_free(dirname);
+	return drift;
+}
+
 static void _new_timers(Clock * clock, GtkWidget * notebook)
 {
 	GtkWidget * vbox;
@@ -385,6 +719,9 @@ static void _new_timers(Clock * clock, GtkWidget * notebook)
 				_clock_on_timer_delete), clock);
 	gtk_toolbar_insert(GTK_TOOLBAR(widget), toolitem, -1);
 	gtk_box_pack_start(GTK_BOX(vbox), widget, FALSE, TRUE, 0);
+	/* search */
+	widget = _new_search(clock, G_CALLBACK(_clock_on_timer_search));
+	gtk_box_pack_start(GTK_BOX(vbox), widget, FALSE, TRUE, 0);
 	/* view */
 	widget = gtk_scrolled_window_new(NULL, NULL);
 	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(widget),
@@ -392,9 +729,16 @@ static void _new_timers(Clock * clock, GtkWidget * notebook)
 	clock->ti_store = gtk_list_store_new(CTC_COUNT,
 			G_TYPE_BOOLEAN,		/* CTC_ACTIVE */
 			G_TYPE_STRING,		/* CTC_TITLE */
-			G_TYPE_STRING);		/* CTC_TIME */
-	clock->ti_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(
-				clock->ti_store));
+			G_TYPE_STRING,		/* CTC_TIME */
+			G_TYPE_UINT,		/* CTC_ID */
+			G_TYPE_INT,		/* CTC_SECONDS */
+			G_TYPE_UINT);		/* CTC_TOLERANCE */
+	clock->ti_filter = gtk_tree_model_filter_new(GTK_TREE_MODEL(
+				clock->ti_store), NULL);
+	gtk_tree_model_filter_set_visible_func(GTK_TREE_MODEL_FILTER(
+				clock->ti_filter), _clock_on_timer_visible,
+			clock, NULL);
+	clock->ti_view = gtk_tree_view_new_with_model(clock->ti_filter);
 	/* active */
 	renderer = gtk_cell_renderer_toggle_new();
 	g_signal_connect(renderer, "toggled", G_CALLBACK(
@@ -413,10 +757,22 @@ static void _new_timers(Clock * clock, GtkWidget * notebook)
 	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->ti_view), column);
 	/* duration */
 	renderer = gtk_cell_renderer_text_new();
-	/* FIXME popup when editing */
+	g_object_set(G_OBJECT(renderer), "editable", TRUE, NULL);
+	g_signal_connect(renderer, "editing-started", G_CALLBACK(
+				_new_timers_on_duration_editing_started),
+			clock);
+	g_signal_connect(renderer, "edited", G_CALLBACK(
+				_new_timers_on_duration_edited), clock);
 	column = gtk_tree_view_column_new_with_attributes(_("Duration"),
 			renderer, "text", CTC_TIME, NULL);
 	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->ti_view), column);
+	/* tolerance */
+	renderer = _new_tolerance();
+	g_signal_connect(renderer, "edited", G_CALLBACK(
+				_clock_on_timer_tolerance_edited), clock);
+	column = gtk_tree_view_column_new_with_attributes(_("Tolerance"),
+			renderer, "text", CTC_TOLERANCE, NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->ti_view), column);
 	gtk_container_add(GTK_CONTAINER(widget), clock->ti_view);
 	gtk_box_pack_start(GTK_BOX(vbox), widget, TRUE, TRUE, 0);
 	gtk_notebook_append_page(GTK_NOTEBOOK(notebook), vbox,
@@ -426,24 +782,181 @@ static void _new_timers(Clock * clock, GtkWidget * notebook)
 static void _new_timers_on_new(gpointer data)
 {
 	Clock * clock = data;
+	ClockRow * row;
+
+	/* index the title first for the filter to show the new row */
+	if(clocksearch_set(clock->ti_search, ++clock->sc_id, _("Timer")) != 0)
+	{
+		_clock_error(clock, error_get(NULL), 1);
+		return;
+	}
+	row = g_new(ClockRow, 1);
+	row->timer = TRUE;
+	row->upcoming = FALSE;
+	gtk_list_store_append(clock->ti_store, &row->iter);
+	gtk_list_store_set(clock->ti_store, &row->iter, CTC_ACTIVE, FALSE,
+			CTC_TITLE, _("Timer"), CTC_ID, clock->sc_id,
+			CTC_SECONDS, -1, CTC_TOLERANCE, CLOCK_TIMER_TOLERANCE,
+			-1);
+	g_hash_table_insert(clock->sc_rows, GUINT_TO_POINTER(clock->sc_id),
+			row);
+}
+
+static void _new_timers_on_duration_changed(GtkEntry * entry)
+{
+	uint32_t duration;
+
+	_new_validate(entry, clockparser_duration(gtk_entry_get_text(entry),
+				&duration) == 0);
+}
+
+static void _new_timers_on_duration_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data)
+{
+	Clock * clock = data;
+	GtkTreeModel * model = GTK_TREE_MODEL(clock->ti_store);
 	GtkTreeIter iter;
+	uint32_t duration;
+	char buf[CLOCKPARSER_SIZE];
+	guint id;
+	(void) renderer;
 
-	gtk_list_store_append(clock->ti_store, &iter);
-	gtk_list_store_set(clock->ti_store, &iter, CTC_ACTIVE, FALSE,
-			CTC_TITLE, _("Timer"), -1);
+	if(_clock_get_iter(clock->ti_filter, &iter, path) != TRUE
+			|| clockparser_duration(text, &duration) != 0
+			|| clockparser_format_duration(duration, buf,
+				sizeof(buf)) == 0)
+		return;
+	gtk_tree_model_get(model, &iter, CTC_ID, &id, -1);
+	gtk_list_store_set(clock->ti_store, &iter, CTC_TIME, buf,
+			CTC_SECONDS, (gint)duration, -1);
+	/* restart the timer with its new duration */
+	clockengine_unset(clock->engine, id);
+	_clock_timer_schedule(clock, &iter);
+}
+
+static void _new_timers_on_duration_editing_started(
+		GtkCellRenderer * renderer, GtkCellEditable * editable,
+		gchar * path, gpointer data)
+{
+	(void) renderer;
+	(void) path;
+	(void) data;
+
+	if(!GTK_IS_ENTRY(editable))
+		return;
+	g_signal_connect(editable, "changed", G_CALLBACK(
+				_new_timers_on_duration_changed), NULL);
+	_new_timers_on_duration_changed(GTK_ENTRY(editable));
 }
 
 static void _new_timers_on_title_edited(GtkCellRendererText * renderer,
 		gchar * path, gchar * text, gpointer data)
 {
 	Clock * clock = data;
-	GtkTreeModel * model = GTK_TREE_MODEL(clock->ti_store);
 	GtkTreeIter iter;
+	guint id;
 	(void) renderer;
 
-	if(gtk_tree_model_get_iter_from_string(model, &iter, path) != TRUE)
+	if(_clock_get_iter(clock->ti_filter, &iter, path) != TRUE)
 		return;
+	gtk_tree_model_get(GTK_TREE_MODEL(clock->ti_store), &iter, CTC_ID, &id,
+			-1);
+	if(clocksearch_set(clock->ti_search, id, text) != 0)
+	{
+		_clock_error(clock, error_get(NULL), 1);
+		return;
+	}
 	gtk_list_store_set(clock->ti_store, &iter, CTC_TITLE, text, -1);
+	_clock_upcoming(clock, id);
+}
+
+static GtkWidget * _new_search(Clock * clock, GCallback callback)
+{
+	GtkWidget * entry;
+
+	entry = gtk_entry_new();
+	gtk_entry_set_max_length(GTK_ENTRY(entry), CLOCKSEARCH_QUERY_MAX - 1);
+#if GTK_CHECK_VERSION(2, 16, 0)
+	gtk_entry_set_icon_from_icon_name(GTK_ENTRY(entry),
+			GTK_ENTRY_ICON_PRIMARY, "edit-find");
+#endif
+#if GTK_CHECK_VERSION(3, 2, 0)
+	gtk_entry_set_placeholder_text(GTK_ENTRY(entry), _("Search"));
+#endif
+	g_signal_connect(entry, "changed", callback, clock);
+	return entry;
+}
+
+static GtkCellRenderer * _new_tolerance(void)
+{
+	GtkCellRenderer * renderer;
+
+	/* in seconds */
+	renderer = gtk_cell_renderer_spin_new();
+	g_object_set(G_OBJECT(renderer), "adjustment", gtk_adjustment_new(
+				0.0, 0.0, 3600.0, 1.0, 60.0, 0.0),
+			"digits", 0, "editable", TRUE, NULL);
+	return renderer;
+}
+
+static void _new_upcoming(Clock * clock, GtkWidget * notebook)
+{
+	GtkWidget * widget;
+	GtkCellRenderer * renderer;
+	GtkTreeViewColumn * column;
+
+	widget = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(widget),
+			GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	/* kept in the order of the scheduler */
+	clock->up_store = gtk_list_store_new(CUC_COUNT,
+			G_TYPE_UINT,		/* CUC_ID */
+			G_TYPE_STRING,		/* CUC_TITLE */
+			G_TYPE_STRING,		/* CUC_TYPE */
+			G_TYPE_INT64);		/* CUC_DEADLINE */
+	clock->up_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(
+				clock->up_store));
+	/* title */
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(_("Title"), renderer,
+			"text", CUC_TITLE, NULL);
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width(column, 150);
+	gtk_tree_view_column_set_expand(column, TRUE);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->up_view), column);
+	/* type */
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(_("Type"), renderer,
+			"text", CUC_TYPE, NULL);
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width(column, 60);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->up_view), column);
+	/* countdown */
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(_("Due"), renderer,
+			NULL);
+	gtk_tree_view_column_set_cell_data_func(column, renderer,
+			_clock_on_upcoming_countdown, clock, NULL);
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width(column, 90);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(clock->up_view), column);
+	/* only measure and render the rows visible */
+	gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(clock->up_view),
+			TRUE);
+	gtk_container_add(GTK_CONTAINER(widget), clock->up_view);
+	gtk_notebook_append_page(GTK_NOTEBOOK(notebook), widget,
+			gtk_label_new(_("Upcoming")));
+}
+
+static void _new_validate(GtkEntry * entry, gboolean valid)
+{
+#if GTK_CHECK_VERSION(2, 16, 0)
+	gtk_entry_set_icon_from_icon_name(entry, GTK_ENTRY_ICON_SECONDARY,
+			valid ? NULL : "dialog-error");
+#else
+	(void) entry;
+	(void) valid;
+#endif
 }
 
 
@@ -452,13 +965,44 @@ void clock_delete(Clock * clock)
 {
 	if(clock->source != 0)
 		g_source_remove(clock->source);
+	if(clock->dr_source != 0)
+		g_source_remove(clock->dr_source);
+	if(clock->sc_source != 0)
+		g_source_remove(clock->sc_source);
+	if(clock->sh_source != 0)
+		g_source_remove(clock->sh_source);
 	gtk_widget_destroy(clock->window);
+	if(clock->shared != NULL)
+		clockshared_delete(clock->shared);
+	if(clock->drift != NULL)
+		clockdrift_delete(clock->drift);
+	g_hash_table_destroy(clock->sc_rows);
+	clocksearch_delete(clock->ti_search);
+	clocksearch_delete(clock->al_search);
+	clockengine_delete(clock->engine);
+	clocksource_delete(clock->clocksource);
 	object_delete(clock);
 }
 
 
 /* private */
 /* functions */
+/* accessors */
+/* clock_get_iter */
+static gboolean _clock_get_iter(GtkTreeModel * filter, GtkTreeIter * iter,
+		gchar const * path)
+{
+	GtkTreeIter fiter;
+
+	/* paths are relative to the filtered view */
+	if(gtk_tree_model_get_iter_from_string(filter, &fiter, path) != TRUE)
+		return FALSE;
+	gtk_tree_model_filter_convert_iter_to_child_iter(GTK_TREE_MODEL_FILTER(
+				filter), iter, &fiter);
+	return TRUE;
+}
+
+
 /* useful */
 /* clock_error */
 static int _clock_error(Clock * clock, char const * message, int ret)
@@ -480,13 +1024,223 @@ static int _clock_error(Clock * clock, char const * message, int ret)
 }
 
 
+/* clock_notify */
+static void _clock_notify(Clock * clock, char const * title,
+		char const * message)
+{
+	GtkWidget * dialog;
+
+	dialog = gtk_message_dialog_new(GTK_WINDOW(clock->window),
+			GTK_DIALOG_DESTROY_WITH_PARENT,
+			GTK_MESSAGE_INFO, GTK_BUTTONS_CLOSE,
+#if GTK_CHECK_VERSION(2, 6, 0)
+			"%s", title);
+	gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+#endif
+			"%s", message);
+	gtk_window_set_title(GTK_WINDOW(dialog), title);
+	g_signal_connect_swapped(dialog, "response", G_CALLBACK(
+				gtk_widget_destroy), dialog);
+	gtk_widget_show(dialog);
+}
+
+
+/* clock_alarm_schedule */
+static void _clock_alarm_schedule(Clock * clock, GtkTreeIter * iter)
+{
+	gboolean active;
+	guint id;
+	gint seconds;
+	guint tolerance;
+	gint64 when;
+
+	gtk_tree_model_get(GTK_TREE_MODEL(clock->al_store), iter,
+			CAC_ACTIVE, &active, CAC_ID, &id, CAC_SECONDS, &seconds,
+			CAC_TOLERANCE, &tolerance, CAC_WHEN, &when, -1);
+	if(active == FALSE || seconds < 0)
+		clockengine_unset(clock->engine, id);
+	else
+		clockengine_set_alarm(clock->engine, id, seconds, when * 1000,
+				(int64_t)tolerance * 1000);
+	_clock_upcoming(clock, id);
+	_clock_schedule(clock);
+}
+
+
+/* clock_schedule */
+static void _clock_schedule(Clock * clock)
+{
+	int64_t slack;
+	int64_t delay;
+
+	if(clock->sc_source != 0)
+		g_source_remove(clock->sc_source);
+	clock->sc_source = 0;
+	if(clockengine_get_wakeup(clock->engine, &delay, &slack) != 0)
+		return;
+	/* wake up early rather than never */
+	if(delay > G_MAXUINT)
+		delay = G_MAXUINT;
+	/* let GLib align the wakeup with its other timers when possible,
+	 * as it may then fire up to a second late */
+	if(slack >= 2000)
+		clock->sc_source = g_timeout_add_seconds((delay + 999) / 1000,
+				_clock_on_schedule, clock);
+	else
+		clock->sc_source = g_timeout_add(delay, _clock_on_schedule,
+				clock);
+}
+
+
+/* clock_search */
+static void _clock_search(Clock * clock, ClockSearch * search,
+		GtkListStore * store, GtkTreeModel * filter, GtkWidget * view,
+		char const * query)
+{
+	GtkTreeModel * model = GTK_TREE_MODEL(store);
+	unsigned int const * ids;
+	size_t count;
+	size_t i;
+	ClockRow * row;
+	GtkTreePath * path;
+
+	if(clocksearch_query(search, query, NULL) != 0)
+		return;
+	if(clocksearch_get_changes(search, &ids, &count) != 0
+			|| count > (size_t)gtk_tree_model_iter_n_children(
+				model, NULL) / 8)
+	{
+		/* most rows change: rebuild the view once instead */
+		g_object_ref(filter);
+		gtk_tree_view_set_model(GTK_TREE_VIEW(view), NULL);
+		gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(filter));
+		gtk_tree_view_set_model(GTK_TREE_VIEW(view), filter);
+		g_object_unref(filter);
+		return;
+	}
+	/* only the rows changing visibility are filtered again */
+	for(i = 0; i < count; i++)
+	{
+		/* deleted since */
+		if((row = g_hash_table_lookup(clock->sc_rows,
+						GUINT_TO_POINTER(ids[i])))
+				== NULL)
+			continue;
+		path = gtk_tree_model_get_path(model, &row->iter);
+		gtk_tree_model_row_changed(model, path, &row->iter);
+		gtk_tree_path_free(path);
+	}
+}
+
+
+/* clock_share */
+static void _clock_share(Clock * clock)
+{
+	/* coalesce the updates */
+	if(clock->shared != NULL && clock->sh_source == 0)
+		clock->sh_source = g_idle_add(_clock_on_share, clock);
+}
+
+
+/* clock_timer_schedule */
+static void _clock_timer_schedule(Clock * clock, GtkTreeIter * iter)
+{
+	gboolean active;
+	guint id;
+	gint seconds;
+	guint tolerance;
+
+	gtk_tree_model_get(GTK_TREE_MODEL(clock->ti_store), iter,
+			CTC_ACTIVE, &active, CTC_ID, &id, CTC_SECONDS, &seconds,
+			CTC_TOLERANCE, &tolerance, -1);
+	if(active == FALSE || seconds < 0)
+		clockengine_unset(clock->engine, id);
+	else
+		/* keeps the current deadline when already running */
+		clockengine_set_timer(clock->engine, id, seconds,
+				(int64_t)tolerance * 1000);
+	_clock_upcoming(clock, id);
+	_clock_schedule(clock);
+}
+
+
+/* clock_upcoming */
+static void _clock_upcoming(Clock * clock, unsigned int id)
+{
+	ClockRow * row;
+	int64_t deadline;
+	size_t position;
+	gchar * title = NULL;
+	GtkTreePath * path;
+
+	if((row = g_hash_table_lookup(clock->sc_rows, GUINT_TO_POINTER(id)))
+			== NULL)
+		return;
+	if(row->upcoming)
+	{
+		/* publish again if leaving the first rows */
+		if((path = gtk_tree_model_get_path(GTK_TREE_MODEL(
+							clock->up_store),
+						&row->up_iter)) != NULL)
+		{
+			if(gtk_tree_path_get_indices(path)[0]
+					< CLOCKSHARED_DEADLINES)
+				_clock_share(clock);
+			gtk_tree_path_free(path);
+		}
+		gtk_list_store_remove(clock->up_store, &row->up_iter);
+		row->upcoming = FALSE;
+	}
+	/* every other row is in place: re-insert at the rank of this one */
+	if(clockengine_get_deadline(clock->engine, id, &deadline) != 0
+			|| clockengine_get_position(clock->engine, id,
+				&position) != 0)
+		return;
+	if(row->timer)
+		gtk_tree_model_get(GTK_TREE_MODEL(clock->ti_store), &row->iter,
+				CTC_TITLE, &title, -1);
+	else
+		gtk_tree_model_get(GTK_TREE_MODEL(clock->al_store), &row->iter,
+				CAC_TITLE, &title, -1);
+	gtk_list_store_insert_with_values(clock->up_store, &row->up_iter,
+			(gint)position, CUC_ID, id, CUC_TITLE, title,
+			CUC_TYPE, row->timer ? _("Timer") : _("Alarm"),
+			CUC_DEADLINE, (gint64)deadline, -1);
+	row->upcoming = TRUE;
+	g_free(title);
+	if(position < CLOCKSHARED_DEADLINES)
+		_clock_share(clock);
+}
+
+
+/* clock_wakeups */
+static void _clock_wakeups(Clock * clock)
+{
+	ClockSchedulerStats stats;
+	double hours;
+	gchar * p;
+
+	if(clock->up_now <= clock->sc_start)
+		return;
+	clockengine_get_stats(clock->engine, &stats);
+	hours = (double)(clock->up_now - clock->sc_start) / 3600000.0;
+	p = g_strdup_printf(_("Wakeups: %.1f/h (%.1f/h without coalescing),"
+				" including %.1f/h for the display"),
+			(stats.wakeups + clock->sc_ticks) / hours,
+			(stats.fired + clock->sc_ticks) / hours,
+			clock->sc_ticks / hours);
+	gtk_label_set_text(GTK_LABEL(clock->cl_wakeups), p);
+	g_free(p);
+}
+
+
 /* callbacks */
 /* clock_on_apply */
 static void _clock_on_apply(gpointer data)
 {
 	Clock * clock = data;
 	struct tm t;
-	struct timeval tv;
+	int64_t when;
 
 	memset(&t, 0, sizeof(t));
 	t.tm_mday = gtk_spin_button_get_value(GTK_SPIN_BUTTON(clock->cl_day));
@@ -497,10 +1251,10 @@ static void _clock_on_apply(gpointer data)
 	t.tm_hour = gtk_spin_button_get_value(GTK_SPIN_BUTTON(clock->cl_hour));
 	t.tm_min = gtk_spin_button_get_value(GTK_SPIN_BUTTON(clock->cl_minute));
 	t.tm_sec = gtk_spin_button_get_value(GTK_SPIN_BUTTON(clock->cl_second));
-	tv.tv_sec = mktime(&t);
-	tv.tv_usec = 0;
-	if(settimeofday(&tv, NULL) != 0)
-		_clock_error(clock, strerror(errno), 1);
+	t.tm_isdst = -1;
+	if((when = clocksource_mktime(clock->clocksource, &t)) < 0
+			|| clocksource_set_time(clock->clocksource, when) != 0)
+		_clock_error(clock, error_get(NULL), 1);
 	else
 		gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(clock->cl_toggle),
 				FALSE);
@@ -517,20 +1271,84 @@ static void _clock_on_close(gpointer data)
 }
 
 
+/* clock_on_share */
+static gboolean _clock_on_share(gpointer data)
+{
+	Clock * clock = data;
+	GtkTreeModel * model = GTK_TREE_MODEL(clock->up_store);
+	GtkTreeIter iter;
+	gboolean valid;
+	ClockSharedTable table;
+	ClockSharedDeadline * d;
+	ClockRow * row;
+	guint id;
+	gchar * title;
+	gint64 deadline;
+	struct tm t;
+
+	clock->sh_source = 0;
+	memset(&table, 0, sizeof(table));
+	table.time = clocksource_get_time(clock->clocksource);
+	table.offset = clocksource_get_offset(clock->clocksource);
+	if(table.time >= 0 && clocksource_localtime(clock->clocksource,
+				table.time, &t) == 0)
+		table.gmtoff = t.tm_gmtoff;
+	clock->sh_gmtoff = table.gmtoff;
+	/* the first rows of the upcoming list are the next deadlines */
+	for(valid = gtk_tree_model_get_iter_first(model, &iter);
+			valid && table.count < CLOCKSHARED_DEADLINES;
+			valid = gtk_tree_model_iter_next(model, &iter))
+	{
+		gtk_tree_model_get(model, &iter, CUC_ID, &id, CUC_TITLE, &title,
+				CUC_DEADLINE, &deadline, -1);
+		d = &table.deadlines[table.count++];
+		d->deadline = deadline;
+		d->id = id;
+		if((row = g_hash_table_lookup(clock->sc_rows,
+						GUINT_TO_POINTER(id))) != NULL
+				&& row->timer)
+			d->flags |= CSF_TIMER;
+		clockshared_set_title(d, title);
+		g_free(title);
+	}
+	clockshared_update(clock->shared, &table);
+	return FALSE;
+}
+
+
 /* clock_on_timeout */
 static gboolean _clock_on_timeout(gpointer data)
 {
 	Clock * clock = data;
-	struct timeval tv;
 	struct tm t;
 
+	/* the wakeups follow the monotonic clock: re-arm them if the time was
+	 * stepped, or after a suspend */
+	if(clockengine_sync(clock->engine) != 0)
+	{
+		_clock_schedule(clock);
+		_clock_share(clock);
+	}
+	clock->sc_ticks++;
+	/* refresh the countdowns when visible */
+	clock->up_now = clocksource_get_time(clock->clocksource);
+	_clock_wakeups(clock);
+#if GTK_CHECK_VERSION(2, 20, 0)
+	if(gtk_widget_get_mapped(clock->up_view))
+#else
+	if(GTK_WIDGET_MAPPED(clock->up_view))
+#endif
+		gtk_widget_queue_draw(clock->up_view);
+	if(clock->up_now < 0 || clocksource_localtime(clock->clocksource,
+				clock->up_now, &t) != 0)
+		/* XXX report error */
+		return TRUE;
+	/* the readers may display the deadlines in local time */
+	if(t.tm_gmtoff != clock->sh_gmtoff)
+		_clock_share(clock);
 	/* do not update if the time is being set */
 	if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(clock->cl_toggle)))
 		return TRUE;
-	if(gettimeofday(&tv, NULL) != 0
-			|| localtime_r(&tv.tv_sec, &t) == NULL)
-		/* XXX report error */
-		return TRUE;
 	/* date */
 	gtk_spin_button_set_value(GTK_SPIN_BUTTON(clock->cl_day), t.tm_mday);
 	gtk_spin_button_set_value(GTK_SPIN_BUTTON(clock->cl_month),
@@ -576,6 +1394,195 @@ static gboolean _clock_on_window_closex(gpointer data)
 }
 
 
+/* drift */
+/* clock_on_drift */
+static gboolean _clock_on_drift(gpointer data)
+{
+	Clock * clock = data;
+	ClockDriftSample sample;
+	gchar * p;
+
+	if(clockdrift_sample(clock->drift, &sample) != 0)
+		return TRUE;
+	p = g_strdup_printf(_("Frequency: %+.3f ppm, drift: %+.3f ms%s"),
+			(double)sample.frequency / 1000.0,
+			(double)sample.drift / 1000000.0,
+			(sample.flags & CDF_STEP) ? _(" (stepped)") : "");
+	gtk_label_set_text(GTK_LABEL(clock->dr_label), p);
+	g_free(p);
+	gtk_widget_queue_draw(clock->dr_area);
+	return TRUE;
+}
+
+
+/* clock_on_drift_draw */
+static void _clock_drift_draw(Clock * clock, GtkWidget * widget,
+		cairo_t * cairo);
+
+#if GTK_CHECK_VERSION(3, 0, 0)
+static gboolean _clock_on_drift_draw(GtkWidget * widget, cairo_t * cairo,
+		gpointer data)
+{
+	Clock * clock = data;
+
+	_clock_drift_draw(clock, widget, cairo);
+	return FALSE;
+}
+#else
+static gboolean _clock_on_drift_expose(GtkWidget * widget,
+		GdkEventExpose * event, gpointer data)
+{
+	Clock * clock = data;
+	cairo_t * cairo;
+	(void) event;
+
+#if GTK_CHECK_VERSION(2, 14, 0)
+	cairo = gdk_cairo_create(gtk_widget_get_window(widget));
+#else
+	cairo = gdk_cairo_create(widget->window);
+#endif
+	_clock_drift_draw(clock, widget, cairo);
+	cairo_destroy(cairo);
+	return FALSE;
+}
+#endif
+
+static void _clock_drift_draw(Clock * clock, GtkWidget * widget,
+		cairo_t * cairo)
+{
+	GtkAllocation a;
+	ClockDriftBucket const * buckets[CLOCKDRIFT_BUCKETS];
+	time_t now;
+	int64_t min = 0;
+	int64_t max = 0;
+	gboolean first = TRUE;
+	double w;
+	double x;
+	size_t i;
+
+	/* only read the downsampled index */
+	now = time(NULL);
+	for(i = 0; i < CLOCKDRIFT_BUCKETS; i++)
+	{
+		if((buckets[i] = clockdrift_get_bucket(clock->drift, now
+						- (CLOCKDRIFT_BUCKETS - 1 - i)
+						* CLOCKDRIFT_BUCKET_SIZE))
+				== NULL)
+			continue;
+		if(first || buckets[i]->min < min)
+			min = buckets[i]->min;
+		if(first || buckets[i]->max > max)
+			max = buckets[i]->max;
+		first = FALSE;
+	}
+	if(first)
+		return;
+	/* at least one millisecond of range */
+	if(max - min < 1000000)
+	{
+		min -= (1000000 - (max - min)) / 2;
+		max = min + 1000000;
+	}
+#if GTK_CHECK_VERSION(2, 18, 0)
+	gtk_widget_get_allocation(widget, &a);
+#else
+	a = widget->allocation;
+#endif
+	w = (double)a.width / CLOCKDRIFT_BUCKETS;
+#define Y(v) (a.height - 1 - (double)((v) - min) * (a.height - 2) \
+		/ (max - min))
+	/* range within each bucket */
+	cairo_set_source_rgba(cairo, 0.2, 0.4, 0.8, 0.3);
+	for(i = 0, x = 0.0; i < CLOCKDRIFT_BUCKETS; i++, x += w)
+		if(buckets[i] != NULL)
+			cairo_rectangle(cairo, x, Y(buckets[i]->max), w,
+					Y(buckets[i]->min)
+					- Y(buckets[i]->max) + 1.0);
+	cairo_fill(cairo);
+	/* steps */
+	cairo_set_source_rgb(cairo, 0.8, 0.2, 0.2);
+	cairo_set_line_width(cairo, 1.0);
+	for(i = 0, x = w / 2.0; i < CLOCKDRIFT_BUCKETS; i++, x += w)
+		if(buckets[i] != NULL && (buckets[i]->flags & CDF_STEP))
+		{
+			cairo_move_to(cairo, x, 0.0);
+			cairo_line_to(cairo, x, a.height);
+		}
+	cairo_stroke(cairo);
+	/* drift */
+	cairo_set_source_rgb(cairo, 0.2, 0.4, 0.8);
+	for(i = 0, x = w / 2.0, first = TRUE; i < CLOCKDRIFT_BUCKETS;
+			i++, x += w)
+		if(buckets[i] == NULL)
+			first = TRUE;
+		else if(first)
+		{
+			cairo_move_to(cairo, x, Y(buckets[i]->last));
+			first = FALSE;
+		}
+		else
+			cairo_line_to(cairo, x, Y(buckets[i]->last));
+	cairo_stroke(cairo);
+#undef Y
+}
+
+
+/* scheduler */
+/* clock_on_schedule */
+static gboolean _clock_on_schedule(gpointer data)
+{
+	Clock * clock = data;
+
+	clock->sc_source = 0;
+	/* counted even if too early */
+	clockengine_fire(clock->engine);
+	_clock_schedule(clock);
+	return FALSE;
+}
+
+
+/* clock_on_schedule_event */
+static void _clock_on_schedule_event(void * data, unsigned int id,
+		ClockEngineEvent event, int64_t deadline, int64_t now)
+{
+	Clock * clock = data;
+	ClockRow * row;
+	gchar * title = NULL;
+	int64_t next;
+	gboolean active;
+	(void) deadline;
+	(void) now;
+
+	if((row = g_hash_table_lookup(clock->sc_rows, GUINT_TO_POINTER(id)))
+			== NULL)
+		return;
+	/* re-scheduled, or no longer scheduled */
+	_clock_upcoming(clock, id);
+	if(event != CEE_FIRED)
+		return;
+	/* only the daily alarms are still active */
+	active = (clockengine_get_deadline(clock->engine, id, &next) == 0)
+		? TRUE : FALSE;
+	if(row->timer)
+	{
+		gtk_tree_model_get(GTK_TREE_MODEL(clock->ti_store), &row->iter,
+				CTC_TITLE, &title, -1);
+		gtk_list_store_set(clock->ti_store, &row->iter, CTC_ACTIVE,
+				active, -1);
+		_clock_notify(clock, _("Timer"), title);
+	}
+	else
+	{
+		gtk_tree_model_get(GTK_TREE_MODEL(clock->al_store), &row->iter,
+				CAC_TITLE, &title, -1);
+		gtk_list_store_set(clock->al_store, &row->iter, CAC_ACTIVE,
+				active, -1);
+		_clock_notify(clock, _("Alarm"), title);
+	}
+	g_free(title);
+}
+
+
 /* alarm */
 /* clock_on_alarm_delete */
 static void _clock_on_alarm_delete(gpointer data)
@@ -587,6 +1594,8 @@ static void _clock_on_alarm_delete(gpointer data)
 	GtkTreeModel * model;
 	GtkTreePath * path;
 	GtkTreeIter iter;
+	GtkTreeIter child;
+	guint id;
 
 	treesel = gtk_tree_view_get_selection(GTK_TREE_VIEW(clock->al_view));
 	if((rows = gtk_tree_selection_get_selected_rows(treesel, &model))
@@ -607,11 +1616,30 @@ static void _clock_on_alarm_delete(gpointer data)
 			continue;
 		gtk_tree_model_get_iter(model, &iter, path);
 		gtk_tree_path_free(path);
-		/* FIXME really implement */
-		gtk_list_store_remove(GTK_LIST_STORE(model), &iter);
+		gtk_tree_model_filter_convert_iter_to_child_iter(
+				GTK_TREE_MODEL_FILTER(model), &child, &iter);
+		gtk_tree_model_get(GTK_TREE_MODEL(clock->al_store), &child,
+				CAC_ID, &id, -1);
+		clockengine_unset(clock->engine, id);
+		_clock_upcoming(clock, id);
+		clocksearch_unset(clock->al_search, id);
+		g_hash_table_remove(clock->sc_rows, GUINT_TO_POINTER(id));
+		gtk_list_store_remove(clock->al_store, &child);
 	}
 	g_list_foreach(rows, (GFunc)gtk_tree_row_reference_free, NULL);
 	g_list_free(rows);
+	_clock_schedule(clock);
+}
+
+
+/* clock_on_alarm_search */
+static void _clock_on_alarm_search(GtkEntry * entry, gpointer data)
+{
+	Clock * clock = data;
+
+	_clock_search(clock, clock->al_search, clock->al_store,
+			clock->al_filter, clock->al_view,
+			gtk_entry_get_text(entry));
 }
 
 
@@ -622,11 +1650,44 @@ static void _clock_on_alarm_toggled(GtkCellRendererToggle * renderer,
 	Clock * clock = data;
 	GtkTreeIter iter;
 
-	gtk_tree_model_get_iter_from_string(GTK_TREE_MODEL(clock->al_store),
-			&iter, path);
+	if(_clock_get_iter(clock->al_filter, &iter, path) != TRUE)
+		return;
 	gtk_list_store_set(clock->al_store, &iter, CAC_ACTIVE,
 			!gtk_cell_renderer_toggle_get_active(renderer), -1);
-	/* FIXME really implement */
+	_clock_alarm_schedule(clock, &iter);
+}
+
+
+/* clock_on_alarm_tolerance_edited */
+static void _clock_on_alarm_tolerance_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data)
+{
+	Clock * clock = data;
+	GtkTreeIter iter;
+	unsigned long tolerance;
+	char * p;
+	(void) renderer;
+
+	if(_clock_get_iter(clock->al_filter, &iter, path) != TRUE)
+		return;
+	tolerance = strtoul(text, &p, 10);
+	if(text[0] == '\0' || *p != '\0' || tolerance > 3600)
+		return;
+	gtk_list_store_set(clock->al_store, &iter, CAC_TOLERANCE,
+			(guint)tolerance, -1);
+	_clock_alarm_schedule(clock, &iter);
+}
+
+
+/* clock_on_alarm_visible */
+static gboolean _clock_on_alarm_visible(GtkTreeModel * model,
+		GtkTreeIter * iter, gpointer data)
+{
+	Clock * clock = data;
+	guint id;
+
+	gtk_tree_model_get(model, iter, CAC_ID, &id, -1);
+	return clocksearch_get_match(clock->al_search, id) ? TRUE : FALSE;
 }
 
 
@@ -641,6 +1702,8 @@ static void _clock_on_timer_delete(gpointer data)
 	GtkTreeModel * model;
 	GtkTreePath * path;
 	GtkTreeIter iter;
+	GtkTreeIter child;
+	guint id;
 
 	treesel = gtk_tree_view_get_selection(GTK_TREE_VIEW(clock->ti_view));
 	if((rows = gtk_tree_selection_get_selected_rows(treesel, &model))
@@ -661,11 +1724,30 @@ static void _clock_on_timer_delete(gpointer data)
 			continue;
 		gtk_tree_model_get_iter(model, &iter, path);
 		gtk_tree_path_free(path);
-		/* FIXME really implement */
-		gtk_list_store_remove(GTK_LIST_STORE(model), &iter);
+		gtk_tree_model_filter_convert_iter_to_child_iter(
+				GTK_TREE_MODEL_FILTER(model), &child, &iter);
+		gtk_tree_model_get(GTK_TREE_MODEL(clock->ti_store), &child,
+				CTC_ID, &id, -1);
+		clockengine_unset(clock->engine, id);
+		_clock_upcoming(clock, id);
+		clocksearch_unset(clock->ti_search, id);
+		g_hash_table_remove(clock->sc_rows, GUINT_TO_POINTER(id));
+		gtk_list_store_remove(clock->ti_store, &child);
 	}
 	g_list_foreach(rows, (GFunc)gtk_tree_row_reference_free, NULL);
 	g_list_free(rows);
+	_clock_schedule(clock);
+}
+
+
+/* clock_on_timer_search */
+static void _clock_on_timer_search(GtkEntry * entry, gpointer data)
+{
+	Clock * clock = data;
+
+	_clock_search(clock, clock->ti_search, clock->ti_store,
+			clock->ti_filter, clock->ti_view,
+			gtk_entry_get_text(entry));
 }
 
 
@@ -676,9 +1758,78 @@ static void _clock_on_timer_toggled(GtkCellRendererToggle * renderer,
 	Clock * clock = data;
 	GtkTreeIter iter;
 
-	gtk_tree_model_get_iter_from_string(GTK_TREE_MODEL(clock->ti_store),
-			&iter, path);
+	if(_clock_get_iter(clock->ti_filter, &iter, path) != TRUE)
+		return;
 	gtk_list_store_set(clock->ti_store, &iter, CTC_ACTIVE,
 			!gtk_cell_renderer_toggle_get_active(renderer), -1);
-	/* FIXME really implement */
+	_clock_timer_schedule(clock, &iter);
+}
+
+
+/* clock_on_timer_tolerance_edited */
+static void _clock_on_timer_tolerance_edited(GtkCellRendererText * renderer,
+		gchar * path, gchar * text, gpointer data)
+{
+	Clock * clock = data;
+	GtkTreeIter iter;
+	unsigned long tolerance;
+	char * p;
+	(void) renderer;
+
+	if(_clock_get_iter(clock->ti_filter, &iter, path) != TRUE)
+		return;
+	tolerance = strtoul(text, &p, 10);
+	if(text[0] == '\0' || *p != '\0' || tolerance > 3600)
+		return;
+	gtk_list_store_set(clock->ti_store, &iter, CTC_TOLERANCE,
+			(guint)tolerance, -1);
+	_clock_timer_schedule(clock, &iter);
+}
+
+
+/* clock_on_timer_visible */
+static gboolean _clock_on_timer_visible(GtkTreeModel * model,
+		GtkTreeIter * iter, gpointer data)
+{
+	Clock * clock = data;
+	guint id;
+
+	gtk_tree_model_get(model, iter, CTC_ID, &id, -1);
+	return clocksearch_get_match(clock->ti_search, id) ? TRUE : FALSE;
+}
+
+
+/* upcoming */
+/* clock_on_upcoming_countdown */
+static void _clock_on_upcoming_countdown(GtkTreeViewColumn * column,
+		GtkCellRenderer * renderer, GtkTreeModel * model,
+		GtkTreeIter * iter, gpointer data)
+{
+	Clock * clock = data;
+	gint64 deadline;
+	int64_t remaining;
+	char buf[32];
+	(void) column;
+
+	/* only called for the rows drawn, against the time of the last tick */
+	gtk_tree_model_get(model, iter, CUC_DEADLINE, &deadline, -1);
+	remaining = (deadline - clock->up_now + 999) / 1000;
+	if(clock->up_now < 0 || remaining <= 0)
+		snprintf(buf, sizeof(buf), "%s", _("now"));
+	else if(remaining < 60)
+		snprintf(buf, sizeof(buf), _("in %us"),
+				(unsigned int)remaining);
+	else if(remaining < 3600)
+		snprintf(buf, sizeof(buf), _("in %um%02us"),
+				(unsigned int)(remaining / 60),
+				(unsigned int)(remaining % 60));
+	else if(remaining < 86400)
+		snprintf(buf, sizeof(buf), _("in %uh%02um"),
+				(unsigned int)(remaining / 3600),
+				(unsigned int)((remaining / 60) % 60));
+	else
+		snprintf(buf, sizeof(buf), _("in %ud%02uh"),
+				(unsigned int)(remaining / 86400),
+				(unsigned int)((remaining / 3600) % 24));
+	g_object_set(G_OBJECT(renderer), "text", buf, NULL);
 }
@@ -0,0 +1,332 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <System.h>
+#include "drift.h"
+
+#ifndef MAP_ANONYMOUS
+# define MAP_ANONYMOUS	MAP_ANON
+#endif
+#ifndef CLOCK_MONOTONIC_RAW
+# define CLOCK_MONOTONIC_RAW	CLOCK_MONOTONIC
+#endif
+#ifndef CLOCK_BOOTTIME
+/* suspends are then recorded as steps */
+# define CLOCK_BOOTTIME		CLOCK_MONOTONIC_RAW
+#endif
+
+
+/* ClockDrift */
+/* private */
+/* types */
+/* on-disk layout */
+typedef struct _ClockDriftFile
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t head;				/* next sample to write */
+	uint32_t count;
+	ClockDriftBucket buckets[CLOCKDRIFT_BUCKETS];
+	ClockDriftSample samples[CLOCKDRIFT_SAMPLES];
+} ClockDriftFile;
+
+struct _ClockDrift
+{
+	ClockDriftFile * file;
+	int fd;					/* locked: one writer */
+};
+
+
+/* constants */
+#define CLOCKDRIFT_MAGIC	"CLKDRIFT"
+#define CLOCKDRIFT_VERSION	2
+
+/* drifting faster than this between two samples is considered a step */
+#define CLOCKDRIFT_STEP_PPM	500
+#define CLOCKDRIFT_STEP_MIN	1000000		/* 1 ms */
+
+
+/* prototypes */
+static int64_t _clockdrift_gettime(clockid_t id);
+static void _clockdrift_index(ClockDrift * drift,
+		ClockDriftSample const * sample);
+static void _clockdrift_record(ClockDrift * drift, ClockDriftSample * sample);
+
+
+/* public */
+/* functions */
+/* clockdrift_new */
+static ClockDriftFile * _new_map(char const * filename, int * fd);
+
+ClockDrift * clockdrift_new(char const * filename)
+{
+	ClockDrift * drift;
+
+	if((drift = object_new(sizeof(*drift))) == NULL)
+		return NULL;
+	if((drift->file = _new_map(filename, &drift->fd)) == NULL)
+	{
+		object_delete(drift);
+		return NULL;
+	}
+	if(memcmp(drift->file->magic, CLOCKDRIFT_MAGIC,
+				sizeof(drift->file->magic)) != 0
+			|| drift->file->version != CLOCKDRIFT_VERSION
+			|| drift->file->capacity != CLOCKDRIFT_SAMPLES
+			|| drift->file->head >= CLOCKDRIFT_SAMPLES
+			|| drift->file->count > CLOCKDRIFT_SAMPLES)
+	{
+		/* (re-)initialize the ring */
+		memset(drift->file, 0, sizeof(*drift->file));
+		memcpy(drift->file->magic, CLOCKDRIFT_MAGIC,
+				sizeof(drift->file->magic));
+		drift->file->version = CLOCKDRIFT_VERSION;
+		drift->file->capacity = CLOCKDRIFT_SAMPLES;
+	}
+	return drift;
+}
+
+static ClockDriftFile * _new_map(char const * filename, int * fd)
+{
+	void * p;
+	struct stat st;
+	int e;
+
+	*fd = -1;
+	if(filename == NULL)
+	{
+		/* not persistent */
+		if((p = mmap(NULL, sizeof(ClockDriftFile),
+						PROT_READ | PROT_WRITE,
+						MAP_PRIVATE | MAP_ANONYMOUS, -1,
+						0)) == MAP_FAILED)
+		{
+			error_set_code(-errno, "%s", strerror(errno));
+			return NULL;
+		}
+		return p;
+	}
+	if((*fd = open(filename, O_RDWR | O_CREAT, 0644)) < 0)
+	{
+		error_set_code(-errno, "%s: %s", filename, strerror(errno));
+		return NULL;
+	}
+	/* another instance may be recording already */
+	if(flock(*fd, LOCK_EX | LOCK_NB) != 0)
+	{
+		e = (errno == EWOULDBLOCK) ? EBUSY : errno;
+		error_set_code(-e, "%s: %s", filename, strerror(e));
+		close(*fd);
+		*fd = -1;
+		return NULL;
+	}
+	if(fstat(*fd, &st) != 0
+			|| (st.st_size != sizeof(ClockDriftFile)
+				&& ftruncate(*fd, sizeof(ClockDriftFile)) != 0)
+			|| (p = mmap(NULL, sizeof(ClockDriftFile),
+					PROT_READ | PROT_WRITE, MAP_SHARED, *fd,
+					0)) == MAP_FAILED)
+	{
+		error_set_code(-errno, "%s: %s", filename, strerror(errno));
+		close(*fd);
+		*fd = -1;
+		return NULL;
+	}
+	/* kept open for the lock */
+	return p;
+}
+
+
+/* clockdrift_delete */
+void clockdrift_delete(ClockDrift * drift)
+{
+	munmap(drift->file, sizeof(*drift->file));
+	if(drift->fd >= 0)
+		close(drift->fd);
+	object_delete(drift);
+}
+
+
+/* accessors */
+/* clockdrift_get_bucket */
+ClockDriftBucket const * clockdrift_get_bucket(ClockDrift * drift,
+		time_t when)
+{
+	ClockDriftBucket const * bucket;
+	int64_t start;
+
+	start = (int64_t)when - ((int64_t)when % CLOCKDRIFT_BUCKET_SIZE);
+	bucket = &drift->file->buckets[(start / CLOCKDRIFT_BUCKET_SIZE)
+		% CLOCKDRIFT_BUCKETS];
+	if(bucket->count == 0 || bucket->time != start)
+		return NULL;
+	return bucket;
+}
+
+
+/* clockdrift_get_count */
+size_t clockdrift_get_count(ClockDrift * drift)
+{
+	return drift->file->count;
+}
+
+
+/* clockdrift_get_last */
+int clockdrift_get_last(ClockDrift * drift, ClockDriftSample * sample)
+{
+	ClockDriftFile * file = drift->file;
+
+	if(file->count == 0)
+		return -1;
+	*sample = file->samples[(file->head + CLOCKDRIFT_SAMPLES - 1)
+		% CLOCKDRIFT_SAMPLES];
+	return 0;
+}
+
+
+/* useful */
+/* clockdrift_sample */
+int clockdrift_sample(ClockDrift * drift, ClockDriftSample * sample)
+{
+	ClockDriftSample s;
+	int64_t raw;
+
+	memset(&s, 0, sizeof(s));
+	/* surround the other clocks to limit the skew between the reads */
+	if((raw = _clockdrift_gettime(CLOCK_MONOTONIC_RAW)) < 0
+			|| (s.realtime = _clockdrift_gettime(CLOCK_REALTIME))
+			< 0
+			|| (s.boottime = _clockdrift_gettime(CLOCK_BOOTTIME))
+			< 0
+			|| (s.raw = _clockdrift_gettime(CLOCK_MONOTONIC_RAW))
+			< 0)
+		return -1;
+	s.raw = raw + (s.raw - raw) / 2;
+	_clockdrift_record(drift, &s);
+	if(sample != NULL)
+		*sample = s;
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* clockdrift_gettime */
+static int64_t _clockdrift_gettime(clockid_t id)
+{
+	struct timespec ts;
+
+	if(clock_gettime(id, &ts) != 0)
+	{
+		error_set_code(-errno, "%s", strerror(errno));
+		return -1;
+	}
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+/* clockdrift_index */
+static void _clockdrift_index(ClockDrift * drift,
+		ClockDriftSample const * sample)
+{
+	ClockDriftBucket * bucket;
+	int64_t start;
+
+	start = sample->realtime / 1000000000;
+	start -= start % CLOCKDRIFT_BUCKET_SIZE;
+	bucket = &drift->file->buckets[(start / CLOCKDRIFT_BUCKET_SIZE)
+		% CLOCKDRIFT_BUCKETS];
+	if(bucket->time != start || bucket->count == 0)
+	{
+		bucket->time = start;
+		bucket->min = sample->drift;
+		bucket->max = sample->drift;
+		bucket->count = 0;
+		bucket->flags = 0;
+	}
+	else if(sample->drift < bucket->min)
+		bucket->min = sample->drift;
+	else if(sample->drift > bucket->max)
+		bucket->max = sample->drift;
+	bucket->last = sample->drift;
+	bucket->count++;
+	bucket->flags |= sample->flags;
+}
+
+
+/* clockdrift_record */
+static void _clockdrift_record(ClockDrift * drift, ClockDriftSample * sample)
+{
+	ClockDriftFile * file = drift->file;
+	ClockDriftSample prev;
+	int64_t delta;
+	int64_t suspended;
+	int64_t threshold;
+	double frequency;
+
+	sample->offset = sample->realtime - sample->raw;
+	if(clockdrift_get_last(drift, &prev) == 0)
+	{
+		sample->drift = prev.drift;
+		sample->frequency = prev.frequency;
+		if(sample->raw <= prev.raw || sample->boottime < prev.boottime)
+			sample->flags |= CDF_REBOOT;
+		else
+		{
+			delta = sample->offset - prev.offset;
+			threshold = (sample->boottime - prev.boottime)
+				/ (1000000 / CLOCKDRIFT_STEP_PPM)
+				+ CLOCKDRIFT_STEP_MIN;
+			/* the raw clock stops while suspended, the boot time
+			 * does not: the realtime clock should jump as much */
+			suspended = (sample->boottime - prev.boottime)
+				- (sample->raw - prev.raw);
+			if(suspended > threshold)
+			{
+				sample->flags |= CDF_SUSPEND;
+				delta -= suspended;
+			}
+			if(delta > threshold || delta < -threshold)
+				sample->flags |= CDF_STEP;
+			else if((sample->flags & CDF_SUSPEND) == 0)
+			{
+				sample->drift += delta;
+				/* smooth the frequency estimate, in double as
+				 * delta * 10^9 overflows after long gaps */
+				frequency = (double)delta * 1000000000.0
+					/ (sample->raw - prev.raw);
+				sample->frequency += (int32_t)((frequency
+							- sample->frequency)
+						/ 4);
+			}
+		}
+	}
+	file->samples[file->head] = *sample;
+	file->head = (file->head + 1) % CLOCKDRIFT_SAMPLES;
+	if(file->count < CLOCKDRIFT_SAMPLES)
+		file->count++;
+	_clockdrift_index(drift, sample);
+}
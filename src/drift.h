@@ -0,0 +1,80 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_DRIFT_H
+# define CLOCK_DRIFT_H
+
+# include <stdint.h>
+# include <time.h>
+
+
+/* ClockDrift */
+/* public */
+/* types */
+typedef struct _ClockDrift ClockDrift;
+
+typedef enum _ClockDriftFlag
+{
+	CDF_STEP = 0x1,				/* the clock was stepped */
+	CDF_REBOOT = 0x2,			/* the raw clock was reset */
+	CDF_SUSPEND = 0x4			/* the system was suspended */
+} ClockDriftFlag;
+
+typedef struct _ClockDriftSample
+{
+	int64_t realtime;			/* CLOCK_REALTIME (ns) */
+	int64_t raw;				/* CLOCK_MONOTONIC_RAW (ns) */
+	int64_t boottime;			/* CLOCK_BOOTTIME (ns) */
+	int64_t offset;				/* realtime - raw (ns) */
+	int64_t drift;				/* accumulated drift (ns) */
+	int32_t frequency;			/* frequency estimate (ppb) */
+	uint32_t flags;				/* ClockDriftFlag */
+} ClockDriftSample;
+
+/* downsampled index, one bucket per hour */
+typedef struct _ClockDriftBucket
+{
+	int64_t time;				/* start of the bucket (s) */
+	int64_t min;				/* minimum drift (ns) */
+	int64_t max;				/* maximum drift (ns) */
+	int64_t last;				/* last drift (ns) */
+	uint32_t count;
+	uint32_t flags;				/* ClockDriftFlag */
+} ClockDriftBucket;
+
+
+/* constants */
+# define CLOCKDRIFT_INTERVAL		60	/* seconds between samples */
+# define CLOCKDRIFT_SAMPLES		10080	/* one week of samples */
+# define CLOCKDRIFT_BUCKET_SIZE		3600	/* seconds per bucket */
+# define CLOCKDRIFT_BUCKETS		168	/* one week of buckets */
+
+
+/* functions */
+ClockDrift * clockdrift_new(char const * filename);
+void clockdrift_delete(ClockDrift * drift);
+
+/* accessors */
+ClockDriftBucket const * clockdrift_get_bucket(ClockDrift * drift,
+		time_t when);
+size_t clockdrift_get_count(ClockDrift * drift);
+int clockdrift_get_last(ClockDrift * drift, ClockDriftSample * sample);
+
+/* useful */
+int clockdrift_sample(ClockDrift * drift, ClockDriftSample * sample);
+
+#endif /* !CLOCK_DRIFT_H */
@@ -0,0 +1,367 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <System.h>
+#include "engine.h"
+
+
+/* ClockEngine */
+/* private */
+/* constants */
+/* the offset is read from two clocks, each truncated to the ms */
+#define CLOCKENGINE_JITTER	1
+
+#define CLOCKENGINE_DAY		(24 * 3600 * 1000)
+
+
+/* types */
+typedef enum _ClockEngineType
+{
+	CET_NONE = 0,
+	CET_ALARM,
+	CET_TIMER
+} ClockEngineType;
+
+typedef struct _ClockEngineEntry
+{
+	ClockEngineType type;
+	int seconds;				/* time of the day or duration */
+	int64_t when;				/* dated alarms */
+	int64_t tolerance;
+	int64_t last;				/* last fired (daily alarms) */
+	int64_t deadline;			/* monotonic (timers) */
+} ClockEngineEntry;
+
+struct _ClockEngine
+{
+	ClockSource * source;
+	ClockScheduler * scheduler;
+	ClockEngineCallback callback;
+	void * data;
+
+	/* indexed by id */
+	ClockEngineEntry * entries;
+	size_t entries_cnt;
+
+	/* the timers are scheduled in wall-clock time with this offset */
+	int64_t offset;
+};
+
+
+/* prototypes */
+static ClockEngineEntry * _clockengine_entry(ClockEngine * engine,
+		unsigned int id);
+static int64_t _clockengine_now(ClockEngine * engine);
+
+/* callbacks */
+static void _clockengine_on_fire(void * data, unsigned int id,
+		int64_t deadline, int64_t now);
+
+
+/* public */
+/* functions */
+/* clockengine_new */
+ClockEngine * clockengine_new(ClockSource * source,
+		ClockEngineCallback callback, void * data)
+{
+	ClockEngine * engine;
+
+	if((engine = object_new(sizeof(*engine))) == NULL)
+		return NULL;
+	memset(engine, 0, sizeof(*engine));
+	if((engine->scheduler = clockscheduler_new()) == NULL)
+	{
+		object_delete(engine);
+		return NULL;
+	}
+	engine->source = source;
+	engine->callback = callback;
+	engine->data = data;
+	engine->offset = clocksource_get_offset(source);
+	return engine;
+}
+
+
+/* clockengine_delete */
+void clockengine_delete(ClockEngine * engine)
+{
+	clockscheduler_delete(engine->scheduler);
+	free(engine->entries);
+	object_delete(engine);
+}
+
+
+/* accessors */
+/* clockengine_get_deadline */
+int clockengine_get_deadline(ClockEngine * engine, unsigned int id,
+		int64_t * deadline)
+{
+	return clockscheduler_get_deadline(engine->scheduler, id, deadline);
+}
+
+
+/* clockengine_get_position */
+int clockengine_get_position(ClockEngine * engine, unsigned int id,
+		size_t * position)
+{
+	return clockscheduler_get_position(engine->scheduler, id, position);
+}
+
+
+/* clockengine_get_stats */
+void clockengine_get_stats(ClockEngine * engine, ClockSchedulerStats * stats)
+{
+	clockscheduler_get_stats(engine->scheduler, stats);
+}
+
+
+/* clockengine_get_wakeup */
+int clockengine_get_wakeup(ClockEngine * engine, int64_t * delay,
+		int64_t * slack)
+{
+	int64_t when;
+	int64_t now;
+
+	if(clockscheduler_get_wakeup(engine->scheduler, &when, slack) != 0
+			|| (now = _clockengine_now(engine)) < 0)
+		return -1;
+	*delay = (when > now) ? when - now : 0;
+	return 0;
+}
+
+
+/* clockengine_set_alarm */
+int clockengine_set_alarm(ClockEngine * engine, unsigned int id, int seconds,
+		int64_t when, int64_t tolerance)
+{
+	ClockEngineEntry * entry;
+	int64_t now;
+	int64_t deadline;
+
+	if((entry = _clockengine_entry(engine, id)) == NULL)
+		return -1;
+	/* a new time of the day may fire again today */
+	if(entry->type != CET_ALARM || entry->seconds != seconds
+			|| entry->when != when)
+		entry->last = 0;
+	entry->type = CET_ALARM;
+	entry->seconds = seconds;
+	entry->when = when;
+	entry->tolerance = tolerance;
+	if(when != 0)
+	{
+		/* dated alarms only fire once */
+		if((now = clocksource_get_time(engine->source)) < 0)
+			return -1;
+		if(when <= now)
+		{
+			clockscheduler_unset(engine->scheduler, id);
+			return 0;
+		}
+		return clockscheduler_set(engine->scheduler, id, when,
+				tolerance);
+	}
+	/* next occurrence of this time of the day */
+	if(clocksource_daily(engine->source, seconds, entry->last, &deadline)
+			!= 0)
+	{
+		clockscheduler_unset(engine->scheduler, id);
+		return -1;
+	}
+	return clockscheduler_set(engine->scheduler, id, deadline, tolerance);
+}
+
+
+/* clockengine_set_timer */
+int clockengine_set_timer(ClockEngine * engine, unsigned int id, int seconds,
+		int64_t tolerance)
+{
+	ClockEngineEntry * entry;
+	int64_t deadline;
+
+	if(seconds < 0)
+		return -error_set_code(1, "%s", strerror(EINVAL));
+	if((entry = _clockengine_entry(engine, id)) == NULL)
+		return -1;
+	/* against the current offset */
+	clockengine_sync(engine);
+	if(entry->type != CET_TIMER || clockscheduler_get_deadline(
+				engine->scheduler, id, &deadline) != 0)
+	{
+		/* timers are durations: not affected by the wall-clock */
+		if((deadline = clocksource_get_monotonic(engine->source)) < 0)
+			return -1;
+		entry->deadline = deadline + (int64_t)seconds * 1000;
+	}
+	entry->type = CET_TIMER;
+	entry->seconds = seconds;
+	entry->when = 0;
+	entry->tolerance = tolerance;
+	return clockscheduler_set(engine->scheduler, id,
+			entry->deadline + engine->offset, tolerance);
+}
+
+
+/* clockengine_unset */
+int clockengine_unset(ClockEngine * engine, unsigned int id)
+{
+	return clockscheduler_unset(engine->scheduler, id);
+}
+
+
+/* useful */
+/* clockengine_fire */
+size_t clockengine_fire(ClockEngine * engine)
+{
+	int64_t now;
+
+	/* the timers must not fire early after a step */
+	clockengine_sync(engine);
+	if((now = _clockengine_now(engine)) < 0)
+		return 0;
+	return clockscheduler_fire(engine->scheduler, now,
+			_clockengine_on_fire, engine);
+}
+
+
+/* clockengine_sync */
+/* returns 1 if the time was stepped or after a suspend, for the wakeup to be
+ * armed again */
+int clockengine_sync(ClockEngine * engine)
+{
+	int64_t offset;
+	int64_t now;
+	int64_t deadline;
+	ClockEngineEntry * entry;
+	size_t i;
+
+	offset = clocksource_get_offset(engine->source);
+	if(offset - engine->offset <= CLOCKENGINE_JITTER
+			&& engine->offset - offset <= CLOCKENGINE_JITTER)
+		return 0;
+	engine->offset = offset;
+	now = _clockengine_now(engine);
+	for(i = 0; i < engine->entries_cnt; i++)
+	{
+		entry = &engine->entries[i];
+		if(clockscheduler_get_deadline(engine->scheduler, i, &deadline)
+				!= 0)
+			continue;
+		if(entry->type == CET_TIMER)
+			/* against the new offset */
+			deadline = entry->deadline + offset;
+		else if(entry->type != CET_ALARM || entry->when != 0
+				|| deadline - now <= CLOCKENGINE_DAY
+				/* stepped back: the days in between fire */
+				|| clocksource_daily(engine->source,
+					entry->seconds, 0, &deadline) != 0)
+			continue;
+		else if(deadline == entry->last)
+			/* unless it fired already on that day */
+			continue;
+		else if(entry->last > now)
+			entry->last = 0;
+		if(clockscheduler_set(engine->scheduler, i, deadline,
+					entry->tolerance) == 0
+				&& engine->callback != NULL)
+			engine->callback(engine->data, i, CEE_MOVED, deadline,
+					now);
+	}
+	return 1;
+}
+
+
+/* private */
+/* functions */
+/* clockengine_entry */
+static ClockEngineEntry * _clockengine_entry(ClockEngine * engine,
+		unsigned int id)
+{
+	ClockEngineEntry * p;
+	size_t cnt;
+
+	if(id >= engine->entries_cnt)
+	{
+		for(cnt = (engine->entries_cnt > 0) ? engine->entries_cnt : 64;
+				cnt <= id; cnt *= 2);
+		if((p = realloc(engine->entries, sizeof(*p) * cnt)) == NULL)
+		{
+			error_set_code(1, "%s", strerror(errno));
+			return NULL;
+		}
+		memset(&p[engine->entries_cnt], 0, sizeof(*p)
+				* (cnt - engine->entries_cnt));
+		engine->entries = p;
+		engine->entries_cnt = cnt;
+	}
+	return &engine->entries[id];
+}
+
+
+/* clockengine_now */
+/* the wall-clock time, consistent with the timers */
+static int64_t _clockengine_now(ClockEngine * engine)
+{
+	int64_t monotonic;
+	int64_t time;
+	int64_t now;
+
+	if((monotonic = clocksource_get_monotonic(engine->source)) < 0)
+		return -1;
+	now = monotonic + engine->offset;
+	/* never fire the alarms early, even within the jitter */
+	if((time = clocksource_get_time(engine->source)) >= 0 && time < now)
+		now = time;
+	return now;
+}
+
+
+/* callbacks */
+/* clockengine_on_fire */
+static void _clockengine_on_fire(void * data, unsigned int id,
+		int64_t deadline, int64_t now)
+{
+	ClockEngine * engine = data;
+	ClockEngineEntry * entry = &engine->entries[id];
+	int64_t next;
+
+	switch(entry->type)
+	{
+		case CET_ALARM:
+			if(entry->when != 0)
+				break;
+			/* alarms repeat every day unless dated */
+			entry->last = deadline;
+			if(clocksource_daily(engine->source, entry->seconds,
+						entry->last, &next) == 0)
+				clockscheduler_set(engine->scheduler, id, next,
+						entry->tolerance);
+			break;
+		case CET_TIMER:
+			/* in monotonic time, and not restarted */
+			deadline = entry->deadline;
+			now -= engine->offset;
+			break;
+		case CET_NONE:
+			break;
+	}
+	if(engine->callback != NULL)
+		engine->callback(engine->data, id, CEE_FIRED, deadline, now);
+}
@@ -0,0 +1,73 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_ENGINE_H
+# define CLOCK_ENGINE_H
+
+# include <stdint.h>
+# include <stddef.h>
+# include "scheduler.h"
+# include "source.h"
+
+
+/* ClockEngine */
+/* public */
+/* types */
+typedef struct _ClockEngine ClockEngine;
+
+typedef enum _ClockEngineEvent
+{
+	CEE_FIRED = 0,
+	CEE_MOVED				/* after a step or a suspend */
+} ClockEngineEvent;
+
+/* the alarms follow the wall-clock time, and the timers the monotonic time:
+ * when fired, the deadline and time given are in the time of the entry (in
+ * ms); when moved, the new deadline is in wall-clock time */
+typedef void (*ClockEngineCallback)(void * data, unsigned int id,
+		ClockEngineEvent event, int64_t deadline, int64_t now);
+
+
+/* functions */
+ClockEngine * clockengine_new(ClockSource * source,
+		ClockEngineCallback callback, void * data);
+void clockengine_delete(ClockEngine * engine);
+
+/* accessors */
+/* the deadlines are all given in wall-clock time */
+int clockengine_get_deadline(ClockEngine * engine, unsigned int id,
+		int64_t * deadline);
+int clockengine_get_position(ClockEngine * engine, unsigned int id,
+		size_t * position);
+void clockengine_get_stats(ClockEngine * engine, ClockSchedulerStats * stats);
+/* the delay is relative to the monotonic time */
+int clockengine_get_wakeup(ClockEngine * engine, int64_t * delay,
+		int64_t * slack);
+
+/* daily alarms if when is 0, or dated (in ms) */
+int clockengine_set_alarm(ClockEngine * engine, unsigned int id, int seconds,
+		int64_t when, int64_t tolerance);
+/* keeps the deadline of a running timer */
+int clockengine_set_timer(ClockEngine * engine, unsigned int id, int seconds,
+		int64_t tolerance);
+int clockengine_unset(ClockEngine * engine, unsigned int id);
+
+/* useful */
+size_t clockengine_fire(ClockEngine * engine);
+int clockengine_sync(ClockEngine * engine);
+
+#endif /* !CLOCK_ENGINE_H */
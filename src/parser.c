@@ -0,0 +1,503 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <string.h>
+#include <langinfo.h>
+#include "parser.h"
+
+
+/* ClockParser */
+/* private */
+/* types */
+typedef enum _ClockParserMeridiem
+{
+	CPM_NONE = 0,
+	CPM_AM,
+	CPM_PM
+} ClockParserMeridiem;
+
+
+/* variables */
+/* from the current locale, lower-case */
+static char _clockparser_am[16];
+static char _clockparser_pm[16];
+
+
+/* prototypes */
+static int64_t _clockparser_days(int year, int month, int day);
+static int _clockparser_days_in_month(int year, int month);
+static char * _clockparser_digits(char * p, unsigned long value,
+		unsigned int digits);
+static int _clockparser_lower(int c);
+static int _clockparser_meridiem(char const ** s);
+static int _clockparser_number(char const ** s, unsigned int min,
+		unsigned int max, unsigned long * value);
+static int _clockparser_offset(char const ** s, ClockParserTime * time);
+static void _clockparser_spaces(char const ** s);
+static int _clockparser_word(char const ** s, char const * word);
+
+
+/* public */
+/* functions */
+/* clockparser_init */
+static void _init_word(char * word, size_t size, char const * string);
+
+void clockparser_init(void)
+{
+	_init_word(_clockparser_am, sizeof(_clockparser_am),
+			nl_langinfo(AM_STR));
+	_init_word(_clockparser_pm, sizeof(_clockparser_pm),
+			nl_langinfo(PM_STR));
+}
+
+static void _init_word(char * word, size_t size, char const * string)
+{
+	size_t i;
+
+	word[0] = '\0';
+	if(string == NULL || strlen(string) >= size)
+		return;
+	for(i = 0; string[i] != '\0'; i++)
+		word[i] = _clockparser_lower((unsigned char)string[i]);
+	word[i] = '\0';
+}
+
+
+/* parsing */
+/* clockparser_duration */
+static int _duration_colons(char const ** s, uint64_t * duration);
+static int _duration_units(char const ** s, uint64_t * duration);
+
+int clockparser_duration(char const * string, uint32_t * duration)
+{
+	char const * s = string;
+	char const * p;
+	uint64_t d = 0;
+
+	_clockparser_spaces(&s);
+	for(p = s; *p >= '0' && *p <= '9'; p++);
+	if(p == s)
+		return -1;
+	if(((*p == ':') ? _duration_colons(&s, &d) : _duration_units(&s, &d))
+			!= 0)
+		return -1;
+	_clockparser_spaces(&s);
+	if(*s != '\0' || d > CLOCKPARSER_DURATION_MAX)
+		return -1;
+	*duration = d;
+	return 0;
+}
+
+static int _duration_colons(char const ** s, uint64_t * duration)
+{
+	unsigned long fields[3];
+	size_t i;
+
+	/* [[H:]M:]S, only the first field may exceed 59 */
+	if(_clockparser_number(s, 1, 9, &fields[0]) != 0)
+		return -1;
+	for(i = 1; i < 3 && **s == ':'; i++)
+	{
+		(*s)++;
+		if(_clockparser_number(s, 2, 2, &fields[i]) != 0
+				|| fields[i] > 59)
+			return -1;
+	}
+	if(i == 2)
+		*duration = (uint64_t)fields[0] * 60 + fields[1];
+	else
+		*duration = ((uint64_t)fields[0] * 60 + fields[1]) * 60
+			+ fields[2];
+	return 0;
+}
+
+static int _duration_units(char const ** s, uint64_t * duration)
+{
+	static const struct
+	{
+		char unit;
+		unsigned long seconds;
+	} units[] = { { 'd', 86400 }, { 'h', 3600 }, { 'm', 60 }, { 's', 1 } };
+	const size_t units_cnt = sizeof(units) / sizeof(*units);
+	size_t u = 0;
+	size_t i;
+	unsigned long value;
+	int c;
+
+	while(_clockparser_number(s, 1, 9, &value) == 0)
+	{
+		_clockparser_spaces(s);
+		c = _clockparser_lower((unsigned char)**s);
+		/* units must come in decreasing order */
+		for(i = u; i < units_cnt && units[i].unit != c; i++);
+		if(i == units_cnt)
+		{
+			/* a bare number is in seconds */
+			if(u != 0 || c != '\0')
+				return -1;
+			*duration = value;
+			return 0;
+		}
+		u = i + 1;
+		*duration += (uint64_t)value * units[i].seconds;
+		if(*duration > CLOCKPARSER_DURATION_MAX)
+			return -1;
+		(*s)++;
+		_clockparser_spaces(s);
+	}
+	return (**s == '\0') ? 0 : -1;
+}
+
+
+/* clockparser_time */
+static int _time_iso8601(char const ** s, ClockParserTime * time);
+static int _time_local(char const ** s, ClockParserTime * time);
+
+int clockparser_time(char const * string, ClockParserTime * time)
+{
+	char const * s = string;
+	char const * p;
+
+	memset(time, 0, sizeof(*time));
+	_clockparser_spaces(&s);
+	for(p = s; *p >= '0' && *p <= '9'; p++);
+	if(((p - s == 4 && *p == '-') ? _time_iso8601(&s, time)
+				: _time_local(&s, time)) != 0)
+		return -1;
+	_clockparser_spaces(&s);
+	return (*s == '\0') ? 0 : -1;
+}
+
+static int _time_iso8601(char const ** s, ClockParserTime * time)
+{
+	unsigned long year;
+	unsigned long month;
+	unsigned long day;
+	unsigned long value;
+
+	/* YYYY-MM-DD[(T| )HH:MM[:SS][Z|(+|-)HH[[:]MM]]] */
+	if(_clockparser_number(s, 4, 4, &year) != 0 || year == 0
+			|| *((*s)++) != '-'
+			|| _clockparser_number(s, 2, 2, &month) != 0
+			|| month < 1 || month > 12
+			|| *((*s)++) != '-'
+			|| _clockparser_number(s, 2, 2, &day) != 0 || day < 1
+			|| (int)day > _clockparser_days_in_month(year, month))
+		return -1;
+	time->year = year;
+	time->month = month;
+	time->day = day;
+	time->flags |= CPTF_DATE;
+	/* a trailing space is not a separator */
+	if((**s != 'T' && **s != 't' && **s != ' ')
+			|| (*s)[1] < '0' || (*s)[1] > '9')
+		return 0;
+	(*s)++;
+	if(_clockparser_number(s, 2, 2, &value) != 0 || value > 23)
+		return -1;
+	time->hour = value;
+	if(*((*s)++) != ':'
+			|| _clockparser_number(s, 2, 2, &value) != 0
+			|| value > 59)
+		return -1;
+	time->minute = value;
+	if(**s == ':')
+	{
+		(*s)++;
+		if(_clockparser_number(s, 2, 2, &value) != 0 || value > 59)
+			return -1;
+		time->second = value;
+	}
+	return _clockparser_offset(s, time);
+}
+
+static int _time_local(char const ** s, ClockParserTime * time)
+{
+	unsigned long value;
+	int colon = 0;
+	int meridiem;
+
+	/* H[:MM[:SS]][ ](am|pm) or H:MM[:SS] */
+	if(_clockparser_number(s, 1, 2, &value) != 0)
+		return -1;
+	time->hour = value;
+	if(**s == ':')
+	{
+		colon = 1;
+		(*s)++;
+		if(_clockparser_number(s, 2, 2, &value) != 0 || value > 59)
+			return -1;
+		time->minute = value;
+		if(**s == ':')
+		{
+			(*s)++;
+			if(_clockparser_number(s, 2, 2, &value) != 0
+					|| value > 59)
+				return -1;
+			time->second = value;
+		}
+	}
+	if((meridiem = _clockparser_meridiem(s)) == CPM_NONE)
+		return (colon && time->hour < 24) ? 0 : -1;
+	if(time->hour < 1 || time->hour > 12)
+		return -1;
+	time->hour %= 12;
+	if(meridiem == CPM_PM)
+		time->hour += 12;
+	return 0;
+}
+
+
+/* formatting */
+/* clockparser_format_duration */
+size_t clockparser_format_duration(uint32_t duration, char * buf,
+		size_t size)
+{
+	char tmp[CLOCKPARSER_SIZE];
+	char * p = tmp;
+	size_t len;
+
+	/* HH:MM:SS */
+	p = _clockparser_digits(p, duration / 3600, 2);
+	*(p++) = ':';
+	p = _clockparser_digits(p, (duration / 60) % 60, 2);
+	*(p++) = ':';
+	p = _clockparser_digits(p, duration % 60, 2);
+	if((len = p - tmp) >= size)
+		return 0;
+	memcpy(buf, tmp, len);
+	buf[len] = '\0';
+	return len;
+}
+
+
+/* clockparser_format_time */
+size_t clockparser_format_time(ClockParserTime const * time, char * buf,
+		size_t size)
+{
+	char tmp[CLOCKPARSER_SIZE];
+	char * p = tmp;
+	int offset;
+	size_t len;
+
+	if(time->flags & CPTF_DATE)
+	{
+		/* YYYY-MM-DDTHH:MM:SS[Z|(+|-)HH:MM] */
+		p = _clockparser_digits(p, time->year, 4);
+		*(p++) = '-';
+		p = _clockparser_digits(p, time->month, 2);
+		*(p++) = '-';
+		p = _clockparser_digits(p, time->day, 2);
+		*(p++) = 'T';
+	}
+	/* HH:MM[:SS] */
+	p = _clockparser_digits(p, time->hour, 2);
+	*(p++) = ':';
+	p = _clockparser_digits(p, time->minute, 2);
+	if(time->second != 0 || (time->flags & CPTF_DATE))
+	{
+		*(p++) = ':';
+		p = _clockparser_digits(p, time->second, 2);
+	}
+	if((time->flags & (CPTF_DATE | CPTF_OFFSET))
+			== (CPTF_DATE | CPTF_OFFSET))
+	{
+		if((offset = time->offset) == 0)
+			*(p++) = 'Z';
+		else
+		{
+			*(p++) = (offset < 0) ? '-' : '+';
+			offset = (offset < 0) ? -offset : offset;
+			p = _clockparser_digits(p, offset / 3600, 2);
+			*(p++) = ':';
+			p = _clockparser_digits(p, (offset / 60) % 60, 2);
+		}
+	}
+	if((len = p - tmp) >= size)
+		return 0;
+	memcpy(buf, tmp, len);
+	buf[len] = '\0';
+	return len;
+}
+
+
+/* useful */
+/* clockparser_time_to_utc */
+int clockparser_time_to_utc(ClockParserTime const * time, int64_t * utc)
+{
+	if((time->flags & (CPTF_DATE | CPTF_OFFSET))
+			!= (CPTF_DATE | CPTF_OFFSET))
+		return -1;
+	*utc = _clockparser_days(time->year, time->month, time->day) * 86400
+		+ time->hour * 3600 + time->minute * 60 + time->second
+		- time->offset;
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* clockparser_days */
+/* days since the Epoch in the proleptic Gregorian calendar */
+static int64_t _clockparser_days(int year, int month, int day)
+{
+	int64_t era;
+	int64_t yoe;
+	int64_t doy;
+
+	year -= (month <= 2) ? 1 : 0;
+	era = ((year >= 0) ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+	return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+
+/* clockparser_days_in_month */
+static int _clockparser_days_in_month(int year, int month)
+{
+	static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31,
+		30, 31 };
+
+	if(month == 2 && (year % 4) == 0
+			&& ((year % 100) != 0 || (year % 400) == 0))
+		return 29;
+	return days[month - 1];
+}
+
+
+/* clockparser_digits */
+static char * _clockparser_digits(char * p, unsigned long value,
+		unsigned int digits)
+{
+	char tmp[20];
+	unsigned int i = 0;
+
+	do
+	{
+		tmp[i++] = '0' + (value % 10);
+		value /= 10;
+	}
+	while(value != 0 && i < sizeof(tmp));
+	for(; i < digits; digits--)
+		*(p++) = '0';
+	while(i > 0)
+		*(p++) = tmp[--i];
+	return p;
+}
+
+
+/* clockparser_lower */
+static int _clockparser_lower(int c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+
+/* clockparser_meridiem */
+static int _clockparser_meridiem(char const ** s)
+{
+	_clockparser_spaces(s);
+	if(_clockparser_word(s, "am") || _clockparser_word(s, "a.m."))
+		return CPM_AM;
+	if(_clockparser_word(s, "pm") || _clockparser_word(s, "p.m."))
+		return CPM_PM;
+	if(_clockparser_am[0] != '\0' && _clockparser_word(s, _clockparser_am))
+		return CPM_AM;
+	if(_clockparser_pm[0] != '\0' && _clockparser_word(s, _clockparser_pm))
+		return CPM_PM;
+	return CPM_NONE;
+}
+
+
+/* clockparser_number */
+static int _clockparser_number(char const ** s, unsigned int min,
+		unsigned int max, unsigned long * value)
+{
+	char const * p = *s;
+	unsigned long v = 0;
+
+	for(; *p >= '0' && *p <= '9' && (unsigned int)(p - *s) < max; p++)
+		v = v * 10 + (*p - '0');
+	if((unsigned int)(p - *s) < min || (*p >= '0' && *p <= '9'))
+		return -1;
+	*s = p;
+	*value = v;
+	return 0;
+}
+
+
+/* clockparser_offset */
+static int _clockparser_offset(char const ** s, ClockParserTime * time)
+{
+	char const * p;
+	int sign;
+	unsigned long hours;
+	unsigned long minutes = 0;
+
+	if(**s == 'Z' || **s == 'z')
+	{
+		(*s)++;
+		time->offset = 0;
+		time->flags |= CPTF_OFFSET;
+		return 0;
+	}
+	if(**s != '+' && **s != '-')
+		return 0;
+	sign = (*((*s)++) == '-') ? -1 : 1;
+	/* HH[[:]MM] */
+	p = *s;
+	if(_clockparser_number(s, 2, 4, &hours) != 0 || *s - p == 3)
+		return -1;
+	if(*s - p == 4)
+	{
+		minutes = hours % 100;
+		hours /= 100;
+	}
+	else if(**s == ':')
+	{
+		(*s)++;
+		if(_clockparser_number(s, 2, 2, &minutes) != 0)
+			return -1;
+	}
+	if(hours > 23 || minutes > 59)
+		return -1;
+	time->offset = sign * (int)(hours * 3600 + minutes * 60);
+	time->flags |= CPTF_OFFSET;
+	return 0;
+}
+
+
+/* clockparser_spaces */
+static void _clockparser_spaces(char const ** s)
+{
+	while(**s == ' ' || **s == '\t')
+		(*s)++;
+}
+
+
+/* clockparser_word */
+static int _clockparser_word(char const ** s, char const * word)
+{
+	char const * p = *s;
+
+	for(; *word != '\0'; p++, word++)
+		if(_clockparser_lower((unsigned char)*p) != *word)
+			return 0;
+	*s = p;
+	return 1;
+}
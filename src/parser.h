@@ -0,0 +1,68 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_PARSER_H
+# define CLOCK_PARSER_H
+
+# include <stdint.h>
+# include <stddef.h>
+
+
+/* ClockParser */
+/* public */
+/* types */
+typedef enum _ClockParserTimeFlag
+{
+	CPTF_DATE = 0x1,			/* the date is set */
+	CPTF_OFFSET = 0x2			/* the UTC offset is set */
+} ClockParserTimeFlag;
+
+typedef struct _ClockParserTime
+{
+	int year;
+	int month;				/* 1 to 12 */
+	int day;				/* 1 to 31 */
+	int hour;				/* 0 to 23 */
+	int minute;
+	int second;
+	int offset;				/* seconds east of UTC */
+	unsigned int flags;			/* ClockParserTimeFlag */
+} ClockParserTime;
+
+
+/* constants */
+# define CLOCKPARSER_DURATION_MAX	0x7fffffff
+# define CLOCKPARSER_SIZE		32	/* enough for any output */
+
+
+/* functions */
+void clockparser_init(void);
+
+/* parsing */
+int clockparser_duration(char const * string, uint32_t * duration);
+int clockparser_time(char const * string, ClockParserTime * time);
+
+/* formatting */
+size_t clockparser_format_duration(uint32_t duration, char * buf,
+		size_t size);
+size_t clockparser_format_time(ClockParserTime const * time, char * buf,
+		size_t size);
+
+/* useful */
+int clockparser_time_to_utc(ClockParserTime const * time, int64_t * utc);
+
+#endif /* !CLOCK_PARSER_H */
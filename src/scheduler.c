@@ -0,0 +1,424 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <System.h>
+#include "scheduler.h"
+
+
+/* ClockScheduler */
+/* private */
+/* constants */
+#define CLOCKSCHEDULER_BLOCK	256
+
+
+/* types */
+typedef struct _ClockSchedulerKey
+{
+	int64_t deadline;
+	unsigned int id;
+} ClockSchedulerKey;
+
+/* the keys are kept sorted in blocks of bounded size */
+typedef struct _ClockSchedulerBlock
+{
+	size_t count;
+	ClockSchedulerKey keys[CLOCKSCHEDULER_BLOCK];
+} ClockSchedulerBlock;
+
+typedef struct _ClockSchedulerEntry
+{
+	int64_t deadline;
+	int64_t tolerance;
+	int scheduled;
+} ClockSchedulerEntry;
+
+struct _ClockScheduler
+{
+	/* indexed by id */
+	ClockSchedulerEntry * entries;
+	size_t entries_cnt;
+
+	/* sorted by deadline */
+	ClockSchedulerBlock ** blocks;
+	size_t blocks_cnt;
+	size_t count;
+
+	ClockSchedulerStats stats;
+};
+
+
+/* prototypes */
+static int _clockscheduler_compare(ClockSchedulerKey const * a,
+		ClockSchedulerKey const * b);
+static size_t _clockscheduler_find(ClockScheduler * scheduler,
+		ClockSchedulerKey const * key);
+static int _clockscheduler_insert(ClockScheduler * scheduler,
+		ClockSchedulerKey const * key);
+static size_t _clockscheduler_lookup(ClockSchedulerBlock * block,
+		ClockSchedulerKey const * key);
+static int _clockscheduler_remove(ClockScheduler * scheduler,
+		ClockSchedulerKey const * key);
+
+
+/* public */
+/* functions */
+/* clockscheduler_new */
+ClockScheduler * clockscheduler_new(void)
+{
+	ClockScheduler * scheduler;
+
+	if((scheduler = object_new(sizeof(*scheduler))) == NULL)
+		return NULL;
+	memset(scheduler, 0, sizeof(*scheduler));
+	return scheduler;
+}
+
+
+/* clockscheduler_delete */
+void clockscheduler_delete(ClockScheduler * scheduler)
+{
+	size_t i;
+
+	for(i = 0; i < scheduler->blocks_cnt; i++)
+		free(scheduler->blocks[i]);
+	free(scheduler->blocks);
+	free(scheduler->entries);
+	object_delete(scheduler);
+}
+
+
+/* accessors */
+/* clockscheduler_get_count */
+size_t clockscheduler_get_count(ClockScheduler * scheduler)
+{
+	return scheduler->count;
+}
+
+
+/* clockscheduler_get_deadline */
+int clockscheduler_get_deadline(ClockScheduler * scheduler, unsigned int id,
+		int64_t * deadline)
+{
+	if(id >= scheduler->entries_cnt
+			|| scheduler->entries[id].scheduled == 0)
+		return -1;
+	*deadline = scheduler->entries[id].deadline;
+	return 0;
+}
+
+
+/* clockscheduler_get_position */
+int clockscheduler_get_position(ClockScheduler * scheduler, unsigned int id,
+		size_t * position)
+{
+	ClockSchedulerKey key;
+	size_t i;
+	size_t j;
+	size_t ret = 0;
+
+	if(id >= scheduler->entries_cnt
+			|| scheduler->entries[id].scheduled == 0)
+		return -1;
+	key.deadline = scheduler->entries[id].deadline;
+	key.id = id;
+	if((i = _clockscheduler_find(scheduler, &key)) == scheduler->blocks_cnt)
+		return -1;
+	/* only the blocks are counted, not their keys */
+	for(j = 0; j < i; j++)
+		ret += scheduler->blocks[j]->count;
+	*position = ret + _clockscheduler_lookup(scheduler->blocks[i], &key);
+	return 0;
+}
+
+
+/* clockscheduler_get_stats */
+void clockscheduler_get_stats(ClockScheduler * scheduler,
+		ClockSchedulerStats * stats)
+{
+	*stats = scheduler->stats;
+}
+
+
+/* clockscheduler_get_wakeup */
+int clockscheduler_get_wakeup(ClockScheduler * scheduler, int64_t * when,
+		int64_t * slack)
+{
+	ClockSchedulerBlock * block;
+	ClockSchedulerKey const * key;
+	int64_t start = 0;
+	int64_t end = INT64_MAX;
+	int64_t e;
+	size_t i;
+	size_t j;
+
+	if(scheduler->count == 0)
+		return -1;
+	/* the earliest end of a window bounds the next wakeup, and every
+	 * entry due by then is coalesced into it */
+	for(i = 0; i < scheduler->blocks_cnt; i++)
+	{
+		block = scheduler->blocks[i];
+		for(j = 0; j < block->count; j++)
+		{
+			key = &block->keys[j];
+			if(key->deadline > end)
+				break;
+			e = key->deadline
+				+ scheduler->entries[key->id].tolerance;
+			if(e < end)
+				end = e;
+			start = key->deadline;
+		}
+		if(j < block->count)
+			break;
+	}
+	*when = start;
+	if(slack != NULL)
+		*slack = end - start;
+	return 0;
+}
+
+
+/* clockscheduler_set */
+int clockscheduler_set(ClockScheduler * scheduler, unsigned int id,
+		int64_t deadline, int64_t tolerance)
+{
+	ClockSchedulerEntry * p;
+	size_t cnt;
+	ClockSchedulerKey key;
+
+	if(id >= scheduler->entries_cnt)
+	{
+		for(cnt = (scheduler->entries_cnt > 0)
+				? scheduler->entries_cnt : 64; cnt <= id;
+				cnt *= 2);
+		if((p = realloc(scheduler->entries, sizeof(*p) * cnt)) == NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		memset(&p[scheduler->entries_cnt], 0, sizeof(*p)
+				* (cnt - scheduler->entries_cnt));
+		scheduler->entries = p;
+		scheduler->entries_cnt = cnt;
+	}
+	if(clockscheduler_unset(scheduler, id) != 0
+			&& scheduler->entries[id].scheduled != 0)
+		return -1;
+	key.deadline = deadline;
+	key.id = id;
+	if(_clockscheduler_insert(scheduler, &key) != 0)
+		return -1;
+	p = &scheduler->entries[id];
+	p->deadline = deadline;
+	p->tolerance = (tolerance > 0) ? tolerance : 0;
+	p->scheduled = 1;
+	return 0;
+}
+
+
+/* clockscheduler_unset */
+int clockscheduler_unset(ClockScheduler * scheduler, unsigned int id)
+{
+	ClockSchedulerKey key;
+
+	if(id >= scheduler->entries_cnt
+			|| scheduler->entries[id].scheduled == 0)
+		return -1;
+	key.deadline = scheduler->entries[id].deadline;
+	key.id = id;
+	if(_clockscheduler_remove(scheduler, &key) != 0)
+		return -1;
+	scheduler->entries[id].scheduled = 0;
+	return 0;
+}
+
+
+/* useful */
+/* clockscheduler_fire */
+size_t clockscheduler_fire(ClockScheduler * scheduler, int64_t now,
+		ClockSchedulerCallback callback, void * data)
+{
+	size_t ret = 0;
+	ClockSchedulerKey key;
+
+	while(scheduler->count > 0
+			&& scheduler->blocks[0]->keys[0].deadline <= now)
+	{
+		key = scheduler->blocks[0]->keys[0];
+		if(_clockscheduler_remove(scheduler, &key) != 0)
+			break;
+		scheduler->entries[key.id].scheduled = 0;
+		ret++;
+		/* the callback may re-schedule this entry */
+		if(callback != NULL)
+			callback(data, key.id, key.deadline, now);
+	}
+	/* early wakeups are wakeups too */
+	scheduler->stats.fired += ret;
+	if(ret == 0)
+		scheduler->stats.empty++;
+	if(scheduler->stats.wakeups++ == 0)
+		scheduler->stats.first = now;
+	scheduler->stats.last = now;
+	return ret;
+}
+
+
+/* private */
+/* functions */
+/* clockscheduler_compare */
+static int _clockscheduler_compare(ClockSchedulerKey const * a,
+		ClockSchedulerKey const * b)
+{
+	if(a->deadline != b->deadline)
+		return (a->deadline < b->deadline) ? -1 : 1;
+	if(a->id != b->id)
+		return (a->id < b->id) ? -1 : 1;
+	return 0;
+}
+
+
+/* clockscheduler_find */
+/* returns the first block whose last key is not lower than key */
+static size_t _clockscheduler_find(ClockScheduler * scheduler,
+		ClockSchedulerKey const * key)
+{
+	size_t low = 0;
+	size_t high = scheduler->blocks_cnt;
+	size_t mid;
+	ClockSchedulerBlock * block;
+
+	while(low < high)
+	{
+		mid = low + (high - low) / 2;
+		block = scheduler->blocks[mid];
+		if(_clockscheduler_compare(&block->keys[block->count - 1], key)
+				< 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+
+/* clockscheduler_insert */
+static int _clockscheduler_insert(ClockScheduler * scheduler,
+		ClockSchedulerKey const * key)
+{
+	ClockSchedulerBlock ** p;
+	ClockSchedulerBlock * block;
+	ClockSchedulerBlock * split;
+	size_t i;
+	size_t pos;
+
+	if((i = _clockscheduler_find(scheduler, key)) == scheduler->blocks_cnt
+			&& i > 0)
+		i--;
+	if(i == scheduler->blocks_cnt
+			|| scheduler->blocks[i]->count == CLOCKSCHEDULER_BLOCK)
+	{
+		/* allocate a new block */
+		if((p = realloc(scheduler->blocks, sizeof(*p)
+						* (scheduler->blocks_cnt + 1)))
+				== NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		scheduler->blocks = p;
+		if((split = malloc(sizeof(*split))) == NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		split->count = 0;
+		if(i < scheduler->blocks_cnt)
+		{
+			/* split the full block in halves */
+			block = scheduler->blocks[i];
+			split->count = block->count / 2;
+			block->count -= split->count;
+			memcpy(split->keys, &block->keys[block->count],
+					sizeof(*split->keys) * split->count);
+			memmove(&p[i + 2], &p[i + 1], sizeof(*p)
+					* (scheduler->blocks_cnt - i - 1));
+			p[i + 1] = split;
+			if(_clockscheduler_compare(
+						&block->keys[block->count - 1],
+						key) < 0)
+				i++;
+		}
+		else
+			p[i] = split;
+		scheduler->blocks_cnt++;
+	}
+	block = scheduler->blocks[i];
+	pos = _clockscheduler_lookup(block, key);
+	memmove(&block->keys[pos + 1], &block->keys[pos], sizeof(*block->keys)
+			* (block->count - pos));
+	block->keys[pos] = *key;
+	block->count++;
+	scheduler->count++;
+	return 0;
+}
+
+
+/* clockscheduler_lookup */
+/* returns the position of the first key not lower than key */
+static size_t _clockscheduler_lookup(ClockSchedulerBlock * block,
+		ClockSchedulerKey const * key)
+{
+	size_t low = 0;
+	size_t high = block->count;
+	size_t mid;
+
+	while(low < high)
+	{
+		mid = low + (high - low) / 2;
+		if(_clockscheduler_compare(&block->keys[mid], key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+
+/* clockscheduler_remove */
+static int _clockscheduler_remove(ClockScheduler * scheduler,
+		ClockSchedulerKey const * key)
+{
+	ClockSchedulerBlock * block;
+	size_t i;
+	size_t pos;
+
+	if((i = _clockscheduler_find(scheduler, key)) == scheduler->blocks_cnt)
+		return -1;
+	block = scheduler->blocks[i];
+	pos = _clockscheduler_lookup(block, key);
+	if(pos == block->count
+			|| _clockscheduler_compare(&block->keys[pos], key) != 0)
+		return -1;
+	memmove(&block->keys[pos], &block->keys[pos + 1], sizeof(*block->keys)
+			* (block->count - pos - 1));
+	scheduler->count--;
+	if(--block->count == 0)
+	{
+		free(block);
+		memmove(&scheduler->blocks[i], &scheduler->blocks[i + 1],
+				sizeof(*scheduler->blocks)
+				* (scheduler->blocks_cnt - i - 1));
+		scheduler->blocks_cnt--;
+	}
+	return 0;
+}
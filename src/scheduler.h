@@ -0,0 +1,67 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_SCHEDULER_H
+# define CLOCK_SCHEDULER_H
+
+# include <stdint.h>
+# include <stddef.h>
+
+
+/* ClockScheduler */
+/* public */
+/* types */
+typedef struct _ClockScheduler ClockScheduler;
+
+typedef struct _ClockSchedulerStats
+{
+	uint64_t fired;				/* entries fired */
+	uint64_t wakeups;			/* actual wakeups */
+	uint64_t empty;				/* without any entry due */
+	int64_t first;				/* time of the first wakeup */
+	int64_t last;				/* time of the last wakeup */
+} ClockSchedulerStats;
+
+/* entries fire within [deadline, deadline + tolerance] (in ms) */
+typedef void (*ClockSchedulerCallback)(void * data, unsigned int id,
+		int64_t deadline, int64_t now);
+
+
+/* functions */
+ClockScheduler * clockscheduler_new(void);
+void clockscheduler_delete(ClockScheduler * scheduler);
+
+/* accessors */
+size_t clockscheduler_get_count(ClockScheduler * scheduler);
+int clockscheduler_get_deadline(ClockScheduler * scheduler, unsigned int id,
+		int64_t * deadline);
+int clockscheduler_get_position(ClockScheduler * scheduler, unsigned int id,
+		size_t * position);
+void clockscheduler_get_stats(ClockScheduler * scheduler,
+		ClockSchedulerStats * stats);
+int clockscheduler_get_wakeup(ClockScheduler * scheduler, int64_t * when,
+		int64_t * slack);
+
+int clockscheduler_set(ClockScheduler * scheduler, unsigned int id,
+		int64_t deadline, int64_t tolerance);
+int clockscheduler_unset(ClockScheduler * scheduler, unsigned int id);
+
+/* useful */
+size_t clockscheduler_fire(ClockScheduler * scheduler, int64_t now,
+		ClockSchedulerCallback callback, void * data);
+
+#endif /* !CLOCK_SCHEDULER_H */
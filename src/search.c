@@ -0,0 +1,492 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <System.h>
+#include <glib.h>
+#include "search.h"
+
+
+/* ClockSearch */
+/* private */
+/* constants */
+#define CLOCKSEARCH_GRAM	3
+
+
+/* types */
+/* the identifiers of the titles containing a given n-gram */
+typedef struct _ClockSearchPosting
+{
+	uint32_t gram;				/* 0 if unused */
+	unsigned int * ids;
+	size_t count;
+	size_t size;
+} ClockSearchPosting;
+
+struct _ClockSearch
+{
+	/* indexed by id */
+	char ** titles;				/* folded */
+	unsigned int * stamps;			/* matches the generation */
+	size_t titles_cnt;
+	size_t count;
+
+	/* n-grams */
+	ClockSearchPosting * postings;
+	size_t postings_size;			/* a power of two */
+	size_t postings_cnt;
+	size_t total;				/* identifiers indexed */
+	size_t live;				/* identifiers still valid */
+
+	/* last query */
+	char query[CLOCKSEARCH_QUERY_MAX];	/* folded */
+	unsigned int generation;
+	unsigned int * results;			/* may be stale */
+	size_t results_cnt;
+	size_t results_size;
+	unsigned int * pending;
+	size_t pending_size;
+
+	/* changed by the last query */
+	unsigned int * changes;
+	size_t changes_cnt;
+	size_t changes_size;
+	int changes_all;
+};
+
+
+/* prototypes */
+static int _clocksearch_append(unsigned int ** ids, size_t * count,
+		size_t * size, unsigned int id);
+static char * _clocksearch_fold(char const * string);
+static uint32_t _clocksearch_gram(char const * string, size_t n);
+static size_t _clocksearch_grams(char const * string);
+static int _clocksearch_index(ClockSearch * search, unsigned int id);
+static ClockSearchPosting * _clocksearch_lookup(ClockSearch * search,
+		uint32_t gram, int create);
+static int _clocksearch_rebuild(ClockSearch * search);
+
+
+/* public */
+/* functions */
+/* clocksearch_new */
+ClockSearch * clocksearch_new(void)
+{
+	ClockSearch * search;
+
+	if((search = object_new(sizeof(*search))) == NULL)
+		return NULL;
+	memset(search, 0, sizeof(*search));
+	search->generation = 1;
+	return search;
+}
+
+
+/* clocksearch_delete */
+void clocksearch_delete(ClockSearch * search)
+{
+	size_t i;
+
+	for(i = 0; i < search->titles_cnt; i++)
+		g_free(search->titles[i]);
+	free(search->titles);
+	free(search->stamps);
+	free(search->results);
+	free(search->pending);
+	free(search->changes);
+	for(i = 0; i < search->postings_size; i++)
+		free(search->postings[i].ids);
+	free(search->postings);
+	object_delete(search);
+}
+
+
+/* accessors */
+/* clocksearch_get_changes */
+/* returns -1 if any identifier may have changed */
+int clocksearch_get_changes(ClockSearch * search, unsigned int const ** ids,
+		size_t * count)
+{
+	if(search->changes_all)
+		return -1;
+	*ids = search->changes;
+	*count = search->changes_cnt;
+	return 0;
+}
+
+
+/* clocksearch_get_match */
+int clocksearch_get_match(ClockSearch * search, unsigned int id)
+{
+	if(search->query[0] == '\0')
+		return 1;
+	return (id < search->titles_cnt
+			&& search->stamps[id] == search->generation) ? 1 : 0;
+}
+
+
+/* clocksearch_set */
+int clocksearch_set(ClockSearch * search, unsigned int id,
+		char const * title)
+{
+	char ** p;
+	unsigned int * q;
+	size_t cnt;
+	char * t;
+	int fresh;
+	int match;
+
+	fresh = (id >= search->titles_cnt || search->titles[id] == NULL);
+	if(id >= search->titles_cnt)
+	{
+		for(cnt = (search->titles_cnt > 0) ? search->titles_cnt : 64;
+				cnt <= id; cnt *= 2);
+		if((p = realloc(search->titles, sizeof(*p) * cnt)) == NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		search->titles = p;
+		if((q = realloc(search->stamps, sizeof(*q) * cnt)) == NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		search->stamps = q;
+		memset(&p[search->titles_cnt], 0, sizeof(*p)
+				* (cnt - search->titles_cnt));
+		memset(&q[search->titles_cnt], 0, sizeof(*q)
+				* (cnt - search->titles_cnt));
+		search->titles_cnt = cnt;
+	}
+	match = (search->stamps[id] == search->generation);
+	t = _clocksearch_fold(title);
+	clocksearch_unset(search, id);
+	search->titles[id] = t;
+	search->count++;
+	/* stale entries are skipped when querying, and eventually dropped */
+	if(_clocksearch_index(search, id) != 0
+			|| (search->total > search->live * 2 + 1024
+				&& _clocksearch_rebuild(search) != 0))
+		return -1;
+	/* keep the current results up to date, new rows showing until the
+	 * next query whatever their title */
+	if(search->query[0] == '\0' || (!fresh
+				&& strstr(t, search->query) == NULL))
+		return 0;
+	if(!match && _clocksearch_append(&search->results,
+				&search->results_cnt, &search->results_size,
+				id) != 0)
+		return -1;
+	search->stamps[id] = search->generation;
+	return 0;
+}
+
+
+/* clocksearch_unset */
+void clocksearch_unset(ClockSearch * search, unsigned int id)
+{
+	if(id >= search->titles_cnt || search->titles[id] == NULL)
+		return;
+	search->live -= _clocksearch_grams(search->titles[id]);
+	g_free(search->titles[id]);
+	search->titles[id] = NULL;
+	search->stamps[id] = 0;
+	search->count--;
+}
+
+
+/* useful */
+/* clocksearch_query */
+int clocksearch_query(ClockSearch * search, char const * query,
+		size_t * count)
+{
+	char * q;
+	size_t len;
+	size_t i;
+	size_t g;
+	size_t n = 0;
+	size_t size;
+	ClockSearchPosting * posting = NULL;
+	ClockSearchPosting * p;
+	unsigned int * r;
+	unsigned int id;
+	unsigned int previous;
+	unsigned int generation;
+	char const * title;
+	int all;
+
+	q = _clocksearch_fold(query);
+	if((len = strlen(q)) >= sizeof(search->query))
+	{
+		g_free(q);
+		return -error_set_code(1, "%s", strerror(ENAMETOOLONG));
+	}
+	/* an empty query matches everything */
+	all = (search->query[0] == '\0');
+	memcpy(search->query, q, len + 1);
+	g_free(q);
+	search->changes_cnt = 0;
+	search->changes_all = (all != (len == 0));
+	previous = search->generation;
+	if(++search->generation == 0)
+	{
+		memset(search->stamps, 0, sizeof(*search->stamps)
+				* search->titles_cnt);
+		search->generation = 1;
+		search->changes_all = !(all && len == 0);
+	}
+	generation = search->generation;
+	if(len == 0)
+	{
+		n = search->count;
+		search->results_cnt = 0;
+		if(count != NULL)
+			*count = n;
+		return 0;
+	}
+	/* only verify the titles for the rarest n-gram */
+	g = (len < CLOCKSEARCH_GRAM) ? len : CLOCKSEARCH_GRAM;
+	for(i = 0; i + g <= len; i++)
+	{
+		if((p = _clocksearch_lookup(search, _clocksearch_gram(
+							&search->query[i], g),
+						0)) == NULL)
+		{
+			posting = NULL;
+			break;
+		}
+		if(posting == NULL || p->count < posting->count)
+			posting = p;
+	}
+	/* the new results, appearing unless they matched already */
+	r = search->pending;
+	search->pending = NULL;
+	for(i = 0; posting != NULL && i < posting->count; i++)
+	{
+		id = posting->ids[i];
+		if(search->stamps[id] == generation
+				|| (title = search->titles[id]) == NULL
+				|| strstr(title, search->query) == NULL)
+			continue;
+		if((search->stamps[id] != previous && !search->changes_all
+					&& _clocksearch_append(
+						&search->changes,
+						&search->changes_cnt,
+						&search->changes_size, id) != 0)
+				|| _clocksearch_append(&r, &n,
+					&search->pending_size, id) != 0)
+		{
+			search->pending = r;
+			search->changes_all = 1;
+			return -1;
+		}
+		search->stamps[id] = generation;
+	}
+	/* the previous results vanishing */
+	for(i = 0; !search->changes_all && i < search->results_cnt; i++)
+		if(search->stamps[(id = search->results[i])] != generation
+				&& _clocksearch_append(&search->changes,
+					&search->changes_cnt,
+					&search->changes_size, id) != 0)
+			search->changes_all = 1;
+	search->pending = search->results;
+	size = search->pending_size;
+	search->pending_size = search->results_size;
+	search->results = r;
+	search->results_cnt = n;
+	search->results_size = size;
+	if(count != NULL)
+		*count = n;
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* clocksearch_append */
+static int _clocksearch_append(unsigned int ** ids, size_t * count,
+		size_t * size, unsigned int id)
+{
+	unsigned int * p;
+	size_t cnt;
+
+	if(*count == *size)
+	{
+		cnt = (*size > 0) ? *size * 2 : 64;
+		if((p = realloc(*ids, sizeof(*p) * cnt)) == NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		*ids = p;
+		*size = cnt;
+	}
+	(*ids)[(*count)++] = id;
+	return 0;
+}
+
+
+/* clocksearch_fold */
+static char * _clocksearch_fold(char const * string)
+{
+	char * p;
+	char * ret;
+
+	if(!g_utf8_validate(string, -1, NULL))
+	{
+		/* only fold ASCII */
+		ret = g_strdup(string);
+		for(p = ret; *p != '\0'; p++)
+			if(*p >= 'A' && *p <= 'Z')
+				*p = *p - 'A' + 'a';
+		return ret;
+	}
+	/* compare canonical forms, whatever the case */
+	p = g_utf8_casefold(string, -1);
+	ret = g_utf8_normalize(p, -1, G_NORMALIZE_ALL_COMPOSE);
+	g_free(p);
+	return ret;
+}
+
+
+/* clocksearch_gram */
+static uint32_t _clocksearch_gram(char const * string, size_t n)
+{
+	unsigned char const * s = (unsigned char const *)string;
+	uint32_t ret = n << 24;
+	size_t i;
+
+	for(i = 0; i < n; i++)
+		ret |= (uint32_t)s[i] << (8 * i);
+	return ret;
+}
+
+
+/* clocksearch_grams */
+static size_t _clocksearch_grams(char const * string)
+{
+	size_t ret = 0;
+	size_t len;
+	size_t n;
+
+	len = strlen(string);
+	for(n = 1; n <= CLOCKSEARCH_GRAM && n <= len; n++)
+		ret += len - n + 1;
+	return ret;
+}
+
+
+/* clocksearch_index */
+static int _clocksearch_index(ClockSearch * search, unsigned int id)
+{
+	char const * title = search->titles[id];
+	ClockSearchPosting * posting;
+	unsigned int * p;
+	size_t size;
+	size_t i;
+	size_t n;
+	size_t len;
+
+	len = strlen(title);
+	for(n = 1; n <= CLOCKSEARCH_GRAM; n++)
+		for(i = 0; i + n <= len; i++)
+		{
+			if((posting = _clocksearch_lookup(search,
+							_clocksearch_gram(
+								&title[i], n),
+							1)) == NULL)
+				return -1;
+			if(posting->count == posting->size)
+			{
+				size = (posting->size > 0)
+					? posting->size * 2 : 4;
+				if((p = realloc(posting->ids, sizeof(*p)
+								* size))
+						== NULL)
+					return -error_set_code(1, "%s",
+							strerror(errno));
+				posting->ids = p;
+				posting->size = size;
+			}
+			posting->ids[posting->count++] = id;
+			search->total++;
+			search->live++;
+		}
+	return 0;
+}
+
+
+/* clocksearch_lookup */
+static ClockSearchPosting * _clocksearch_lookup(ClockSearch * search,
+		uint32_t gram, int create)
+{
+	ClockSearchPosting * p;
+	ClockSearchPosting * q;
+	size_t size;
+	size_t i;
+	size_t j;
+
+	if(create && (search->postings_cnt + 1) * 2 > search->postings_size)
+	{
+		/* grow and re-hash */
+		size = (search->postings_size > 0)
+			? search->postings_size * 2 : 1024;
+		if((p = calloc(size, sizeof(*p))) == NULL)
+		{
+			error_set_code(1, "%s", strerror(errno));
+			return NULL;
+		}
+		for(i = 0; i < search->postings_size; i++)
+		{
+			q = &search->postings[i];
+			if(q->gram == 0)
+				continue;
+			for(j = (q->gram * 2654435761U) & (size - 1);
+					p[j].gram != 0; j = (j + 1) & (size - 1));
+			p[j] = *q;
+		}
+		free(search->postings);
+		search->postings = p;
+		search->postings_size = size;
+	}
+	if(search->postings_size == 0)
+		return NULL;
+	for(i = (gram * 2654435761U) & (search->postings_size - 1);
+			search->postings[i].gram != 0;
+			i = (i + 1) & (search->postings_size - 1))
+		if(search->postings[i].gram == gram)
+			return &search->postings[i];
+	if(!create)
+		return NULL;
+	p = &search->postings[i];
+	p->gram = gram;
+	search->postings_cnt++;
+	return p;
+}
+
+
+/* clocksearch_rebuild */
+static int _clocksearch_rebuild(ClockSearch * search)
+{
+	size_t i;
+
+	for(i = 0; i < search->postings_size; i++)
+		search->postings[i].count = 0;
+	search->total = 0;
+	search->live = 0;
+	for(i = 0; i < search->titles_cnt; i++)
+		if(search->titles[i] != NULL
+				&& _clocksearch_index(search, i) != 0)
+			return -1;
+	return 0;
+}
+
@@ -0,0 +1,52 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_SEARCH_H
+# define CLOCK_SEARCH_H
+
+# include <stddef.h>
+
+
+/* ClockSearch */
+/* public */
+/* types */
+typedef struct _ClockSearch ClockSearch;
+
+
+/* constants */
+# define CLOCKSEARCH_QUERY_MAX		256
+
+
+/* functions */
+ClockSearch * clocksearch_new(void);
+void clocksearch_delete(ClockSearch * search);
+
+/* accessors */
+int clocksearch_get_changes(ClockSearch * search, unsigned int const ** ids,
+		size_t * count);
+int clocksearch_get_match(ClockSearch * search, unsigned int id);
+
+/* new identifiers match until the next query */
+int clocksearch_set(ClockSearch * search, unsigned int id,
+		char const * title);
+void clocksearch_unset(ClockSearch * search, unsigned int id);
+
+/* useful */
+int clocksearch_query(ClockSearch * search, char const * query,
+		size_t * count);
+
+#endif /* !CLOCK_SEARCH_H */
@@ -0,0 +1,392 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "shared.h"
+
+
+/* ClockShared */
+/* private */
+/* types */
+/* shared layout */
+typedef struct _ClockSharedPage
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t sequence;			/* odd while being updated */
+	ClockSharedTable table;
+} ClockSharedPage;
+
+/* copied with atomic accesses, the readers racing with the writer */
+typedef uint64_t __attribute__((__may_alias__)) ClockSharedWord;
+
+struct _ClockShared
+{
+	ClockSharedPage * page;
+	char name[64];
+	int fd;					/* locked: one writer */
+};
+
+struct _ClockSharedReader
+{
+	ClockSharedPage const * page;
+};
+
+
+/* constants */
+#define CLOCKSHARED_MAGIC	"CLKSHARE"
+#define CLOCKSHARED_VERSION	1
+
+/* let a pre-empted writer complete its update */
+#define CLOCKSHARED_SPINS	64
+/* give up on a writer interrupted during an update */
+#define CLOCKSHARED_RETRIES	100000
+/* give up on writers replacing the table as fast */
+#define CLOCKSHARED_ATTEMPTS	3
+
+
+/* prototypes */
+static int _clockshared_check(int fd, struct stat * st);
+static void _clockshared_load(ClockSharedTable * table,
+		ClockSharedTable const * from);
+static int _clockshared_lock(char const * name);
+static char const * _clockshared_name(char const * name, char * buf,
+		size_t size);
+static int _clockshared_same(char const * name, struct stat const * st);
+static void _clockshared_store(ClockSharedTable * table,
+		ClockSharedTable const * from);
+
+
+/* public */
+/* functions */
+/* writer */
+/* clockshared_new */
+ClockShared * clockshared_new(char const * name)
+{
+	ClockShared * shared;
+	ClockSharedPage * page;
+	void * p;
+	int e;
+
+	if((shared = malloc(sizeof(*shared))) == NULL)
+		return NULL;
+	name = _clockshared_name(name, shared->name, sizeof(shared->name));
+	if((shared->fd = _clockshared_lock(name)) < 0)
+	{
+		free(shared);
+		return NULL;
+	}
+	if(ftruncate(shared->fd, sizeof(*page)) != 0
+			|| (p = mmap(NULL, sizeof(*page),
+					PROT_READ | PROT_WRITE, MAP_SHARED,
+					shared->fd, 0)) == MAP_FAILED)
+	{
+		e = errno;
+		close(shared->fd);
+		free(shared);
+		errno = e;
+		return NULL;
+	}
+	shared->page = page = p;
+	if(memcmp(page->magic, CLOCKSHARED_MAGIC, sizeof(page->magic)) != 0
+			|| page->version != CLOCKSHARED_VERSION)
+	{
+		memset(page, 0, sizeof(*page));
+		page->version = CLOCKSHARED_VERSION;
+		memcpy(page->magic, CLOCKSHARED_MAGIC, sizeof(page->magic));
+	}
+	/* the previous writer may have been interrupted */
+	if(page->sequence & 1)
+		__atomic_store_n(&page->sequence, page->sequence + 1,
+				__ATOMIC_RELEASE);
+	return shared;
+}
+
+
+/* clockshared_delete */
+void clockshared_delete(ClockShared * shared)
+{
+	ClockSharedPage * page = shared->page;
+	uint32_t sequence;
+
+	/* tell the readers still mapping the table to open the next one */
+	sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n((ClockSharedWord *)page->magic, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->sequence, sequence + 2, __ATOMIC_RELEASE);
+	munmap(page, sizeof(*page));
+	/* still holding the lock: the name is ours */
+	shm_unlink(shared->name);
+	close(shared->fd);
+	free(shared);
+}
+
+
+/* clockshared_update */
+void clockshared_update(ClockShared * shared, ClockSharedTable * table)
+{
+	ClockSharedPage * page = shared->page;
+	uint32_t sequence;
+
+	sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+	table->generation = sequence / 2 + 1;
+	__atomic_store_n(&page->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	_clockshared_store(&page->table, table);
+	__atomic_store_n(&page->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+
+/* readers */
+/* clockshared_open */
+ClockSharedReader * clockshared_open(char const * name)
+{
+	ClockSharedReader * reader;
+	ClockSharedPage const * page;
+	char buf[64];
+	void * p = MAP_FAILED;
+	int fd;
+	struct stat st;
+	int e;
+
+	if((reader = malloc(sizeof(*reader))) == NULL)
+		return NULL;
+	name = _clockshared_name(name, buf, sizeof(buf));
+	if((fd = shm_open(name, O_RDONLY, 0)) < 0)
+	{
+		free(reader);
+		return NULL;
+	}
+	/* nor trust someone else's table */
+	if(_clockshared_check(fd, &st) != 0)
+		e = errno;
+	else if(st.st_size < (off_t)sizeof(*page))
+		/* not initialized */
+		e = EPROTO;
+	else if((p = mmap(NULL, sizeof(*page), PROT_READ, MAP_SHARED, fd, 0))
+			== MAP_FAILED)
+		e = errno;
+	/* the mapping remains valid */
+	close(fd);
+	if(p == MAP_FAILED)
+	{
+		free(reader);
+		errno = e;
+		return NULL;
+	}
+	reader->page = page = p;
+	if(memcmp(page->magic, CLOCKSHARED_MAGIC, sizeof(page->magic)) != 0
+			|| page->version != CLOCKSHARED_VERSION)
+	{
+		clockshared_close(reader);
+		errno = EPROTO;
+		return NULL;
+	}
+	return reader;
+}
+
+
+/* clockshared_close */
+void clockshared_close(ClockSharedReader * reader)
+{
+	munmap((void *)reader->page, sizeof(*reader->page));
+	free(reader);
+}
+
+
+/* clockshared_get_generation */
+/* to poll cheaply before reading: also changes once the table is closed */
+uint32_t clockshared_get_generation(ClockSharedReader * reader)
+{
+	return __atomic_load_n(&reader->page->sequence, __ATOMIC_ACQUIRE) / 2;
+}
+
+
+/* clockshared_read */
+int clockshared_read(ClockSharedReader * reader, ClockSharedTable * table)
+{
+	ClockSharedPage const * page = reader->page;
+	uint32_t sequence;
+	ClockSharedWord magic;
+	size_t i;
+
+	for(i = 0; i < CLOCKSHARED_RETRIES; i++)
+	{
+		if(i >= CLOCKSHARED_SPINS)
+			sched_yield();
+		if((sequence = __atomic_load_n(&page->sequence,
+						__ATOMIC_ACQUIRE)) & 1)
+			continue;
+		magic = __atomic_load_n((ClockSharedWord const *)page->magic,
+				__ATOMIC_RELAXED);
+		_clockshared_load(table, &page->table);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&page->sequence, __ATOMIC_RELAXED)
+				!= sequence)
+			continue;
+		/* cleared when the writer is gone */
+		if(memcmp(&magic, CLOCKSHARED_MAGIC, sizeof(magic)) != 0)
+		{
+			errno = ESTALE;
+			return -1;
+		}
+		return 0;
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+
+/* useful */
+/* clockshared_set_title */
+void clockshared_set_title(ClockSharedDeadline * deadline,
+		char const * title)
+{
+	size_t len;
+
+	if(title == NULL)
+		title = "";
+	/* do not split multi-byte characters */
+	if((len = strlen(title)) >= sizeof(deadline->title))
+		for(len = sizeof(deadline->title) - 1; len > 0
+				&& ((unsigned char)title[len] & 0xc0) == 0x80;
+				len--);
+	memcpy(deadline->title, title, len);
+	memset(&deadline->title[len], 0, sizeof(deadline->title) - len);
+}
+
+
+/* private */
+/* functions */
+/* clockshared_check */
+/* only the user may have created the table, and be able to access it */
+static int _clockshared_check(int fd, struct stat * st)
+{
+	if(fstat(fd, st) != 0)
+		return -1;
+	if(st->st_uid != getuid() || (st->st_mode & 0777) != 0600)
+	{
+		errno = EPERM;
+		return -1;
+	}
+	return 0;
+}
+
+
+/* clockshared_load */
+static void _clockshared_load(ClockSharedTable * table,
+		ClockSharedTable const * from)
+{
+	ClockSharedWord * p = (ClockSharedWord *)table;
+	ClockSharedWord const * q = (ClockSharedWord const *)from;
+	size_t i;
+
+	for(i = 0; i < sizeof(*table) / sizeof(*p); i++)
+		p[i] = __atomic_load_n(&q[i], __ATOMIC_RELAXED);
+}
+
+
+/* clockshared_lock */
+/* returns a descriptor locked for writing, and still linked to the name */
+static int _clockshared_lock(char const * name)
+{
+	int fd;
+	struct stat st;
+	size_t i;
+	int e;
+
+	for(i = 0; i < CLOCKSHARED_ATTEMPTS; i++)
+	{
+		if((fd = shm_open(name, O_RDWR | O_CREAT, 0600)) < 0)
+			return -1;
+		/* never write to someone else's table */
+		if(_clockshared_check(fd, &st) != 0)
+		{
+			e = errno;
+			close(fd);
+			errno = e;
+			return -1;
+		}
+		if(flock(fd, LOCK_EX | LOCK_NB) != 0)
+		{
+			/* another writer is running */
+			e = (errno == EWOULDBLOCK) ? EBUSY : errno;
+			close(fd);
+			errno = e;
+			return -1;
+		}
+		/* unless unlinked by the previous writer in the meantime */
+		if(_clockshared_same(name, &st) == 0)
+			return fd;
+		close(fd);
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+
+/* clockshared_name */
+static char const * _clockshared_name(char const * name, char * buf,
+		size_t size)
+{
+	if(name != NULL)
+		snprintf(buf, size, "%s", name);
+	else
+		/* one per user */
+		snprintf(buf, size, "%s-%lu", CLOCKSHARED_NAME,
+				(unsigned long)getuid());
+	return buf;
+}
+
+
+/* clockshared_same */
+static int _clockshared_same(char const * name, struct stat const * st)
+{
+	int fd;
+	struct stat s;
+	int ret;
+
+	if((fd = shm_open(name, O_RDONLY, 0)) < 0)
+		return -1;
+	ret = (fstat(fd, &s) == 0 && s.st_dev == st->st_dev
+			&& s.st_ino == st->st_ino) ? 0 : -1;
+	close(fd);
+	return ret;
+}
+
+
+/* clockshared_store */
+static void _clockshared_store(ClockSharedTable * table,
+		ClockSharedTable const * from)
+{
+	ClockSharedWord * p = (ClockSharedWord *)table;
+	ClockSharedWord const * q = (ClockSharedWord const *)from;
+	size_t i;
+
+	for(i = 0; i < sizeof(*table) / sizeof(*p); i++)
+		__atomic_store_n(&p[i], q[i], __ATOMIC_RELAXED);
+}
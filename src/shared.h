@@ -0,0 +1,83 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_SHARED_H
+# define CLOCK_SHARED_H
+
+# include <stdint.h>
+
+
+/* ClockShared */
+/* public */
+/* constants */
+# define CLOCKSHARED_DEADLINES		8
+# define CLOCKSHARED_NAME		"/DeforaOS-Clock"	/* -uid */
+# define CLOCKSHARED_TITLE		48
+
+
+/* types */
+typedef struct _ClockShared ClockShared;
+typedef struct _ClockSharedReader ClockSharedReader;
+
+typedef enum _ClockSharedFlag
+{
+	CSF_TIMER = 0x1				/* otherwise an alarm */
+} ClockSharedFlag;
+
+typedef struct _ClockSharedDeadline
+{
+	int64_t deadline;			/* wall clock time (ms) */
+	uint32_t id;
+	uint32_t flags;				/* ClockSharedFlag */
+	char title[CLOCKSHARED_TITLE];		/* UTF-8, truncated */
+} ClockSharedDeadline;
+
+typedef struct _ClockSharedTable
+{
+	uint32_t generation;			/* counts the updates */
+	int32_t gmtoff;				/* local - UTC (s) */
+	int64_t offset;				/* wall - monotonic */
+	int64_t time;				/* wall clock time (ms) */
+	uint32_t count;
+	uint32_t padding;
+	/* the next deadlines, in order */
+	ClockSharedDeadline deadlines[CLOCKSHARED_DEADLINES];
+} ClockSharedTable;
+
+
+/* functions */
+/* errors are reported in errno, for the readers not to depend on libSystem */
+/* writer */
+ClockShared * clockshared_new(char const * name);
+void clockshared_delete(ClockShared * shared);
+
+void clockshared_update(ClockShared * shared, ClockSharedTable * table);
+
+/* readers */
+ClockSharedReader * clockshared_open(char const * name);
+void clockshared_close(ClockSharedReader * reader);
+
+uint32_t clockshared_get_generation(ClockSharedReader * reader);
+
+/* fails with ESTALE once the writer is gone: the table must be opened again */
+int clockshared_read(ClockSharedReader * reader, ClockSharedTable * table);
+
+/* useful */
+void clockshared_set_title(ClockSharedDeadline * deadline,
+		char const * title);
+
+#endif /* !CLOCK_SHARED_H */
@@ -0,0 +1,296 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <sys/time.h>
+#include <string.h>
+#include <errno.h>
+#include <System.h>
+#include "source.h"
+
+
+/* ClockSource */
+/* private */
+/* constants */
+#define CLOCKSOURCE_DAY		(24 * 3600 * 1000)
+
+
+/* types */
+struct _ClockSource
+{
+	int64_t (*get_monotonic)(ClockSource * source);
+	int64_t (*get_time)(ClockSource * source);
+	int (*set_time)(ClockSource * source, int64_t time);
+
+	/* virtual clocks */
+	int virtual;
+	int64_t monotonic;
+	int64_t time;
+};
+
+
+/* prototypes */
+/* system */
+static int64_t _clocksource_system_get_monotonic(ClockSource * source);
+static int64_t _clocksource_system_get_time(ClockSource * source);
+static int _clocksource_system_set_time(ClockSource * source, int64_t time);
+
+/* virtual */
+static int64_t _clocksource_virtual_get_monotonic(ClockSource * source);
+static int64_t _clocksource_virtual_get_time(ClockSource * source);
+static int _clocksource_virtual_set_time(ClockSource * source, int64_t time);
+
+
+/* public */
+/* functions */
+/* clocksource_new */
+ClockSource * clocksource_new(void)
+{
+	ClockSource * source;
+
+	if((source = object_new(sizeof(*source))) == NULL)
+		return NULL;
+	memset(source, 0, sizeof(*source));
+	source->get_monotonic = _clocksource_system_get_monotonic;
+	source->get_time = _clocksource_system_get_time;
+	source->set_time = _clocksource_system_set_time;
+	return source;
+}
+
+
+/* clocksource_new_virtual */
+ClockSource * clocksource_new_virtual(int64_t time)
+{
+	ClockSource * source;
+
+	if((source = object_new(sizeof(*source))) == NULL)
+		return NULL;
+	memset(source, 0, sizeof(*source));
+	source->get_monotonic = _clocksource_virtual_get_monotonic;
+	source->get_time = _clocksource_virtual_get_time;
+	source->set_time = _clocksource_virtual_set_time;
+	source->virtual = 1;
+	source->time = time;
+	return source;
+}
+
+
+/* clocksource_delete */
+void clocksource_delete(ClockSource * source)
+{
+	object_delete(source);
+}
+
+
+/* accessors */
+/* clocksource_get_monotonic */
+int64_t clocksource_get_monotonic(ClockSource * source)
+{
+	return source->get_monotonic(source);
+}
+
+
+/* clocksource_get_offset */
+/* changes when the clock is stepped, or after a suspend */
+int64_t clocksource_get_offset(ClockSource * source)
+{
+	int64_t time;
+	int64_t monotonic;
+
+	if((time = source->get_time(source)) < 0
+			|| (monotonic = source->get_monotonic(source)) < 0)
+		return 0;
+	return time - monotonic;
+}
+
+
+/* clocksource_get_time */
+int64_t clocksource_get_time(ClockSource * source)
+{
+	return source->get_time(source);
+}
+
+
+/* clocksource_set_time */
+int clocksource_set_time(ClockSource * source, int64_t time)
+{
+	if(time < 0)
+		return -error_set_code(1, "%s", strerror(EINVAL));
+	return source->set_time(source, time);
+}
+
+
+/* useful */
+/* clocksource_daily */
+/* next occurrence of a local time of the day, given the last one if any */
+int clocksource_daily(ClockSource * source, int seconds, int64_t last,
+		int64_t * deadline)
+{
+	int64_t now;
+	int64_t base;
+	int64_t t;
+	struct tm tm;
+	struct tm day;
+	int i;
+
+	if(seconds < 0 || seconds >= 24 * 3600)
+		return -error_set_code(1, "%s", strerror(EINVAL));
+	if((now = clocksource_get_time(source)) < 0)
+		return -1;
+	/* never fire twice on the same day, as when the hour is repeated
+	 * while leaving DST */
+	base = (last > 0 && last <= now && now - last < CLOCKSOURCE_DAY)
+		? last : now;
+	if(clocksource_localtime(source, base, &day) != 0)
+		return -1;
+	i = (base == last || day.tm_hour * 3600 + day.tm_min * 60
+			+ day.tm_sec >= seconds) ? 1 : 0;
+	for(;; i++)
+	{
+		memset(&tm, 0, sizeof(tm));
+		tm.tm_year = day.tm_year;
+		tm.tm_mon = day.tm_mon;
+		tm.tm_mday = day.tm_mday + i;
+		tm.tm_hour = seconds / 3600;
+		tm.tm_min = (seconds / 60) % 60;
+		tm.tm_sec = seconds % 60;
+		tm.tm_isdst = -1;
+		if((t = clocksource_mktime(source, &tm)) < 0)
+			return -1;
+		if(t > now)
+			break;
+		if(i > 1)
+			return -error_set_code(1, "%s", strerror(ERANGE));
+	}
+	*deadline = t;
+	return 0;
+}
+
+
+/* clocksource_localtime */
+int clocksource_localtime(ClockSource * source, int64_t time, struct tm * tm)
+{
+	time_t t = time / 1000;
+	(void) source;
+
+	if(localtime_r(&t, tm) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	return 0;
+}
+
+
+/* clocksource_mktime */
+int64_t clocksource_mktime(ClockSource * source, struct tm * tm)
+{
+	time_t t;
+	(void) source;
+
+	if((t = mktime(tm)) == -1)
+		return -error_set_code(1, "%s", strerror(ERANGE));
+	return (int64_t)t * 1000;
+}
+
+
+/* virtual clocks */
+/* clocksource_advance */
+int clocksource_advance(ClockSource * source, int64_t duration)
+{
+	if(source->virtual == 0)
+		return -error_set_code(1, "%s", strerror(ENOTSUP));
+	if(duration < 0)
+		return -error_set_code(1, "%s", strerror(EINVAL));
+	source->monotonic += duration;
+	source->time += duration;
+	return 0;
+}
+
+
+/* clocksource_suspend */
+/* the monotonic clock stops while suspended */
+int clocksource_suspend(ClockSource * source, int64_t duration)
+{
+	if(source->virtual == 0)
+		return -error_set_code(1, "%s", strerror(ENOTSUP));
+	if(duration < 0)
+		return -error_set_code(1, "%s", strerror(EINVAL));
+	source->time += duration;
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* system */
+/* clocksource_system_get_monotonic */
+static int64_t _clocksource_system_get_monotonic(ClockSource * source)
+{
+	struct timespec ts;
+	(void) source;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return -1;
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/* clocksource_system_get_time */
+static int64_t _clocksource_system_get_time(ClockSource * source)
+{
+	struct timeval tv;
+	(void) source;
+
+	if(gettimeofday(&tv, NULL) != 0)
+		return -1;
+	return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
+/* clocksource_system_set_time */
+static int _clocksource_system_set_time(ClockSource * source, int64_t time)
+{
+	struct timeval tv;
+	(void) source;
+
+	tv.tv_sec = time / 1000;
+	tv.tv_usec = (time % 1000) * 1000;
+	if(settimeofday(&tv, NULL) != 0)
+		return -error_set_code(1, "%s", strerror(errno));
+	return 0;
+}
+
+
+/* virtual */
+/* clocksource_virtual_get_monotonic */
+static int64_t _clocksource_virtual_get_monotonic(ClockSource * source)
+{
+	return source->monotonic;
+}
+
+
+/* clocksource_virtual_get_time */
+static int64_t _clocksource_virtual_get_time(ClockSource * source)
+{
+	return source->time;
+}
+
+
+/* clocksource_virtual_set_time */
+/* steps the clock */
+static int _clocksource_virtual_set_time(ClockSource * source, int64_t time)
+{
+	source->time = time;
+	return 0;
+}
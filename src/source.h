@@ -0,0 +1,55 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef CLOCK_SOURCE_H
+# define CLOCK_SOURCE_H
+
+# include <stdint.h>
+# include <time.h>
+
+
+/* ClockSource */
+/* public */
+/* types */
+typedef struct _ClockSource ClockSource;
+
+
+/* functions */
+/* the system clock */
+ClockSource * clocksource_new(void);
+/* a virtual clock, starting at the time given (in ms) */
+ClockSource * clocksource_new_virtual(int64_t time);
+void clocksource_delete(ClockSource * source);
+
+/* accessors */
+int64_t clocksource_get_monotonic(ClockSource * source);
+int64_t clocksource_get_offset(ClockSource * source);
+int64_t clocksource_get_time(ClockSource * source);
+
+int clocksource_set_time(ClockSource * source, int64_t time);
+
+/* useful */
+int clocksource_daily(ClockSource * source, int seconds, int64_t last,
+		int64_t * deadline);
+int clocksource_localtime(ClockSource * source, int64_t time, struct tm * tm);
+int64_t clocksource_mktime(ClockSource * source, struct tm * tm);
+
+/* virtual clocks */
+int clocksource_advance(ClockSource * source, int64_t duration);
+int clocksource_suspend(ClockSource * source, int64_t duration);
+
+#endif /* !CLOCK_SOURCE_H */
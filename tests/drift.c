@@ -0,0 +1,375 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stddef.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "../src/drift.c"
+
+#ifndef PROGNAME
+# define PROGNAME	"drift"
+#endif
+
+
+/* private */
+/* types */
+typedef struct _Machine
+{
+	int64_t realtime;
+	int64_t raw;
+	int64_t boottime;
+} Machine;
+
+
+/* constants */
+#define START		1792368000	/* on the hour */
+#define INTERVAL	60000000000LL	/* one minute (ns) */
+#define DRIFT		600000		/* 10 ppm per interval (ns) */
+
+
+/* prototypes */
+static int _buckets(ClockDrift * drift, size_t count);
+static int _events(void);
+static int _lock(char const * filename);
+static int _recovery(char const * filename);
+static int _reopen(char const * filename, size_t count);
+static int _wrap(char const * filename, size_t * count);
+
+static int _error(char const * message, size_t n);
+static void _record(ClockDrift * drift, Machine * machine,
+		ClockDriftSample * sample);
+static void _tick(Machine * machine);
+static int _usage(void);
+
+
+/* functions */
+/* buckets */
+/* sample i was taken during hour i / 60, with a drift of i * DRIFT */
+static int _buckets(ClockDrift * drift, size_t count)
+{
+	ClockDriftBucket const * bucket;
+	size_t hours = (count + 59) / 60;
+	size_t h;
+	size_t first;
+	size_t last;
+
+	for(h = 0; h < hours; h++)
+	{
+		bucket = clockdrift_get_bucket(drift, START + h * 3600 + 1800);
+		if(h + CLOCKDRIFT_BUCKETS < hours)
+		{
+			/* overwritten */
+			if(bucket != NULL)
+				return _error("bucket not expired", h);
+			continue;
+		}
+		first = h * 60;
+		last = (first + 59 < count) ? first + 59 : count - 1;
+		if(bucket == NULL
+				|| bucket->time != (int64_t)(START + h * 3600)
+				|| bucket->count != last - first + 1
+				|| bucket->min != (int64_t)(first * DRIFT)
+				|| bucket->max != (int64_t)(last * DRIFT)
+				|| bucket->last != (int64_t)(last * DRIFT)
+				|| bucket->flags != 0)
+			return _error("invalid bucket", h);
+	}
+	return 0;
+}
+
+
+/* events */
+static int _events(void)
+{
+	ClockDrift * drift;
+	Machine machine = { (int64_t)START * 1000000000, 1000000000,
+		1000000000 };
+	ClockDriftSample prev;
+	ClockDriftSample sample;
+	ClockDriftBucket const * bucket;
+	int ret = 0;
+
+	if((drift = clockdrift_new(NULL)) == NULL)
+		return 2;
+	_record(drift, &machine, &prev);
+	_tick(&machine);
+	_record(drift, &machine, &prev);
+	/* suspended for eight hours: neither a step nor any drift */
+	_tick(&machine);
+	machine.realtime += 8 * 3600000000000LL;
+	machine.boottime += 8 * 3600000000000LL;
+	_record(drift, &machine, &sample);
+	if(sample.flags != CDF_SUSPEND || sample.drift != prev.drift
+			|| sample.frequency != prev.frequency)
+		ret |= _error("suspend not detected", 0);
+	_tick(&machine);
+	_record(drift, &machine, &sample);
+	if(sample.flags != 0 || sample.drift != prev.drift + DRIFT)
+		ret |= _error("drift not resumed", 0);
+	if((bucket = clockdrift_get_bucket(drift, sample.realtime
+						/ 1000000000)) == NULL
+			|| bucket->flags != CDF_SUSPEND)
+		ret |= _error("suspend not indexed", 0);
+	/* stepped */
+	prev = sample;
+	_tick(&machine);
+	machine.realtime += 5000000000LL;
+	_record(drift, &machine, &sample);
+	if(sample.flags != CDF_STEP || sample.drift != prev.drift)
+		ret |= _error("step not detected", 0);
+	/* stepped while suspended */
+	_tick(&machine);
+	machine.realtime += 3600000000000LL - 2000000000LL;
+	machine.boottime += 3600000000000LL;
+	_record(drift, &machine, &sample);
+	if(sample.flags != (CDF_SUSPEND | CDF_STEP))
+		ret |= _error("step not detected while suspended", 0);
+	/* slewed by NTP */
+	prev = sample;
+	_tick(&machine);
+	machine.boottime += INTERVAL / 2000;
+	_record(drift, &machine, &sample);
+	if(sample.flags != 0 || sample.drift != prev.drift + DRIFT)
+		ret |= _error("slew detected as a suspend", 0);
+	/* three days without a sample, at 40 ppm */
+	prev = sample;
+	machine.realtime += 3 * 86400000000000LL + 3 * 86400000LL * 40;
+	machine.raw += 3 * 86400000000000LL;
+	machine.boottime += 3 * 86400000000000LL;
+	_record(drift, &machine, &sample);
+	if(sample.flags != 0 || sample.drift != prev.drift
+			+ 3 * 86400000LL * 40
+			|| sample.frequency != prev.frequency
+			+ (40000 - prev.frequency) / 4)
+		ret |= _error("frequency wrong after a long gap", 0);
+	/* rebooted */
+	machine.raw = 1000000000;
+	machine.boottime = 1000000000;
+	_tick(&machine);
+	_record(drift, &machine, &sample);
+	if(sample.flags != CDF_REBOOT)
+		ret |= _error("reboot not detected", 0);
+	clockdrift_delete(drift);
+	return ret;
+}
+
+
+/* lock */
+/* one instance records at a time */
+static int _lock(char const * filename)
+{
+	ClockDrift * drift;
+	ClockDrift * second;
+	int ret = 0;
+
+	if((drift = clockdrift_new(filename)) == NULL)
+		return 2;
+	if((second = clockdrift_new(filename)) != NULL)
+	{
+		clockdrift_delete(second);
+		ret |= _error("ring opened twice", 0);
+	}
+	clockdrift_delete(drift);
+	/* the next instance may record */
+	if((drift = clockdrift_new(filename)) == NULL)
+		return _error("ring still locked", 0);
+	clockdrift_delete(drift);
+	return ret;
+}
+
+
+/* recovery */
+static int _recovery(char const * filename)
+{
+	ClockDrift * drift;
+	uint32_t head = CLOCKDRIFT_SAMPLES;
+	uint32_t version = CLOCKDRIFT_VERSION - 1;
+	int fd;
+	int ret = 0;
+
+	/* corrupted */
+	if((fd = open(filename, O_WRONLY)) < 0
+			|| pwrite(fd, &head, sizeof(head),
+				offsetof(ClockDriftFile, head))
+			!= sizeof(head)
+			|| close(fd) != 0)
+		return _error("could not corrupt the ring", 0);
+	if((drift = clockdrift_new(filename)) == NULL)
+		return 2;
+	if(clockdrift_get_count(drift) != 0)
+		ret |= _error("corrupted ring not reset", 0);
+	clockdrift_delete(drift);
+	/* previous version */
+	if((fd = open(filename, O_WRONLY)) < 0
+			|| pwrite(fd, &version, sizeof(version),
+				offsetof(ClockDriftFile, version))
+			!= sizeof(version)
+			|| close(fd) != 0)
+		return _error("could not downgrade the ring", 0);
+	if((drift = clockdrift_new(filename)) == NULL)
+		return 2;
+	if(clockdrift_get_count(drift) != 0)
+		ret |= _error("previous version not reset", 0);
+	clockdrift_delete(drift);
+	/* truncated */
+	if(truncate(filename, 100) != 0)
+		return _error("could not truncate the ring", 0);
+	if((drift = clockdrift_new(filename)) == NULL)
+		return 2;
+	if(clockdrift_get_count(drift) != 0)
+		ret |= _error("truncated ring not reset", 0);
+	clockdrift_delete(drift);
+	return ret;
+}
+
+
+/* reopen */
+static int _reopen(char const * filename, size_t count)
+{
+	ClockDrift * drift;
+	ClockDriftSample last;
+	ClockDriftSample sample;
+	Machine machine;
+	int ret;
+
+	if((drift = clockdrift_new(filename)) == NULL)
+		return 2;
+	if(clockdrift_get_count(drift) != CLOCKDRIFT_SAMPLES
+			|| clockdrift_get_last(drift, &last) != 0
+			|| last.drift != (int64_t)((count - 1) * DRIFT))
+	{
+		clockdrift_delete(drift);
+		return _error("ring not recovered", count);
+	}
+	/* carry on where we stopped */
+	machine.realtime = last.realtime;
+	machine.raw = last.raw;
+	machine.boottime = last.boottime;
+	_tick(&machine);
+	_record(drift, &machine, &sample);
+	ret = (sample.flags == 0 && sample.drift == last.drift + DRIFT)
+		? _buckets(drift, count + 1) : _error("ring not resumed", 0);
+	clockdrift_delete(drift);
+	return ret;
+}
+
+
+/* wrap */
+static int _wrap(char const * filename, size_t * count)
+{
+	ClockDrift * drift;
+	Machine machine = { (int64_t)START * 1000000000, 1000000000,
+		1000000000 };
+	ClockDriftSample sample;
+	ClockDriftSample last;
+	size_t i;
+	int ret = 0;
+
+	unlink(filename);
+	if((drift = clockdrift_new(filename)) == NULL)
+		return 2;
+	*count = CLOCKDRIFT_SAMPLES + 100;
+	for(i = 0; i < *count; i++)
+	{
+		_record(drift, &machine, &sample);
+		_tick(&machine);
+	}
+	if(clockdrift_get_count(drift) != CLOCKDRIFT_SAMPLES
+			|| drift->file->head != 100)
+		ret |= _error("invalid count", clockdrift_get_count(drift));
+	if(clockdrift_get_last(drift, &last) != 0
+			|| memcmp(&last, &sample, sizeof(last)) != 0)
+		ret |= _error("invalid last sample", 0);
+	/* the oldest sample left */
+	if(drift->file->samples[100].drift != 100 * DRIFT)
+		ret |= _error("invalid oldest sample", 100);
+	if(last.drift != (int64_t)((*count - 1) * DRIFT)
+			|| last.frequency < 9990 || last.frequency > 10000)
+		ret |= _error("invalid drift", 0);
+	ret |= _buckets(drift, *count);
+	clockdrift_delete(drift);
+	return ret;
+}
+
+
+/* error */
+static int _error(char const * message, size_t n)
+{
+	fprintf(stderr, "%s: %s (%zu)\n", PROGNAME, message, n);
+	return 2;
+}
+
+
+/* record */
+static void _record(ClockDrift * drift, Machine * machine,
+		ClockDriftSample * sample)
+{
+	memset(sample, 0, sizeof(*sample));
+	sample->realtime = machine->realtime;
+	sample->raw = machine->raw;
+	sample->boottime = machine->boottime;
+	_clockdrift_record(drift, sample);
+}
+
+
+/* tick */
+static void _tick(Machine * machine)
+{
+	machine->realtime += INTERVAL + DRIFT;
+	machine->raw += INTERVAL;
+	machine->boottime += INTERVAL;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fprintf(stderr, "Usage: %s [-f filename]\n", PROGNAME);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	char const * filename = "drift.ring";
+	size_t count = 0;
+	int o;
+	int ret;
+
+	while((o = getopt(argc, argv, "f:")) != -1)
+		switch(o)
+		{
+			case 'f':
+				filename = optarg;
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	ret = _events();
+	if((ret |= _wrap(filename, &count)) == 0)
+		ret |= _reopen(filename, count);
+	ret |= _recovery(filename);
+	ret |= _lock(filename);
+	unlink(filename);
+	if(ret == 0)
+		printf("%s: %zu samples, %u buckets\n", PROGNAME, count + 1,
+				CLOCKDRIFT_BUCKETS);
+	return ret;
+}
@@ -0,0 +1,280 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "../src/parser.c"
+
+#ifndef PROGNAME
+# define PROGNAME	"parser"
+#endif
+
+
+/* private */
+/* constants */
+#define FUZZ		1000000
+#define BENCHMARK	10000000
+#define THROUGHPUT	10000000	/* parses per second */
+
+
+/* prototypes */
+static int _benchmark(void);
+static int _durations(void);
+static int _fuzz_durations(void);
+static int _fuzz_garbage(void);
+static int _fuzz_times(void);
+static int _times(void);
+
+static int _error(char const * string, char const * message);
+
+
+/* functions */
+/* benchmark */
+static int _benchmark(void)
+{
+	char const * strings[] = { "07:30", "7:30pm", "2026-10-19T07:30:00Z",
+		"1h30m", "90s", "01:30:00" };
+	const size_t strings_cnt = sizeof(strings) / sizeof(*strings);
+	ClockParserTime t;
+	uint32_t d;
+	struct timespec before;
+	struct timespec after;
+	double elapsed;
+	size_t i;
+	size_t errors = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	for(i = 0; i < BENCHMARK; i++)
+		if(((i % strings_cnt) < 3)
+				? clockparser_time(strings[i % strings_cnt],
+					&t) != 0
+				: clockparser_duration(strings[i % strings_cnt],
+					&d) != 0)
+			errors++;
+	clock_gettime(CLOCK_MONOTONIC, &after);
+	elapsed = (after.tv_sec - before.tv_sec)
+		+ (after.tv_nsec - before.tv_nsec) / 1000000000.0;
+	printf("%s: %u parses in %.3fs (%.1f million per second)\n",
+			PROGNAME, BENCHMARK, elapsed,
+			BENCHMARK / elapsed / 1000000.0);
+	if(errors != 0)
+		return _error("benchmark", "failed to parse");
+	return (BENCHMARK / elapsed >= THROUGHPUT) ? 0
+		: _error("benchmark", "too slow");
+}
+
+
+/* durations */
+static int _durations(void)
+{
+	const struct
+	{
+		char const * string;
+		uint32_t duration;
+	} valid[] = {
+		{ "1h30m", 5400 }, { "90s", 90 }, { "01:30:00", 5400 },
+		{ "90", 90 }, { "1h 30m", 5400 }, { " 2D ", 172800 },
+		{ "1d2h3m4s", 93784 }, { "5:07", 307 }, { "100:00:00", 360000 }
+	};
+	char const * invalid[] = { "", "h", "1x", "1m1h", "1h1h", "1h30",
+		"1:60", "1:2", "1:00:00:00", "-1s", "99999999999", "1h-",
+		"999999999d" };
+	size_t i;
+	uint32_t d;
+
+	for(i = 0; i < sizeof(valid) / sizeof(*valid); i++)
+		if(clockparser_duration(valid[i].string, &d) != 0
+				|| d != valid[i].duration)
+			return _error(valid[i].string, "invalid duration");
+	for(i = 0; i < sizeof(invalid) / sizeof(*invalid); i++)
+		if(clockparser_duration(invalid[i], &d) == 0)
+			return _error(invalid[i], "should not parse");
+	return 0;
+}
+
+
+/* fuzz_durations */
+static int _fuzz_durations(void)
+{
+	char buf[CLOCKPARSER_SIZE];
+	uint32_t d;
+	uint32_t e;
+	size_t i;
+
+	for(i = 0; i < FUZZ; i++)
+	{
+		d = ((uint32_t)rand() ^ ((uint32_t)rand() << 16))
+			% (CLOCKPARSER_DURATION_MAX + 1U);
+		if(clockparser_format_duration(d, buf, sizeof(buf)) == 0
+				|| clockparser_duration(buf, &e) != 0
+				|| e != d)
+			return _error(buf, "duration round trip failed");
+	}
+	return 0;
+}
+
+
+/* fuzz_garbage */
+static int _fuzz_garbage(void)
+{
+	static const char alphabet[] = "0123456789:-+TZ hmsdapAPM.";
+	char string[16];
+	char buf[CLOCKPARSER_SIZE];
+	char buf2[CLOCKPARSER_SIZE];
+	ClockParserTime t;
+	ClockParserTime t2;
+	uint32_t d;
+	size_t i;
+	size_t j;
+	size_t len;
+
+	/* whatever parses must be formatted and parsed back identically */
+	for(i = 0; i < FUZZ; i++)
+	{
+		len = rand() % (sizeof(string) - 1);
+		for(j = 0; j < len; j++)
+			string[j] = alphabet[rand() % (sizeof(alphabet) - 1)];
+		string[len] = '\0';
+		if(clockparser_time(string, &t) == 0
+				&& (clockparser_format_time(&t, buf,
+						sizeof(buf)) == 0
+					|| clockparser_time(buf, &t2) != 0
+					|| memcmp(&t, &t2, sizeof(t)) != 0
+					|| clockparser_format_time(&t2, buf2,
+						sizeof(buf2)) == 0
+					|| strcmp(buf, buf2) != 0))
+			return _error(string, "time round trip failed");
+		if(clockparser_duration(string, &d) == 0
+				&& (clockparser_format_duration(d, buf,
+						sizeof(buf)) == 0
+					|| clockparser_duration(buf, &d) != 0
+					|| clockparser_format_duration(d, buf2,
+						sizeof(buf2)) == 0
+					|| strcmp(buf, buf2) != 0))
+			return _error(string, "duration round trip failed");
+	}
+	return 0;
+}
+
+
+/* fuzz_times */
+static int _fuzz_times(void)
+{
+	char buf[CLOCKPARSER_SIZE];
+	ClockParserTime t;
+	ClockParserTime t2;
+	size_t i;
+
+	for(i = 0; i < FUZZ; i++)
+	{
+		memset(&t, 0, sizeof(t));
+		t.hour = rand() % 24;
+		t.minute = rand() % 60;
+		t.second = (rand() % 2) ? rand() % 60 : 0;
+		if(rand() % 2)
+		{
+			t.flags |= CPTF_DATE;
+			t.year = 1 + rand() % 9999;
+			t.month = 1 + rand() % 12;
+			t.day = 1 + rand() % _clockparser_days_in_month(t.year,
+					t.month);
+			if(rand() % 2)
+			{
+				t.flags |= CPTF_OFFSET;
+				t.offset = (rand() % (24 * 60 * 2 - 1)
+						- (24 * 60 - 1)) * 60;
+			}
+		}
+		if(clockparser_format_time(&t, buf, sizeof(buf)) == 0
+				|| clockparser_time(buf, &t2) != 0
+				|| memcmp(&t, &t2, sizeof(t)) != 0)
+			return _error(buf, "time round trip failed");
+	}
+	return 0;
+}
+
+
+/* times */
+static int _times(void)
+{
+	const struct
+	{
+		char const * string;
+		int hour;
+		int minute;
+		int second;
+	} valid[] = {
+		{ "07:30", 7, 30, 0 }, { "7:30pm", 19, 30, 0 },
+		{ "7:30 PM", 19, 30, 0 }, { "12am", 0, 0, 0 },
+		{ "12pm", 12, 0, 0 }, { "12:15:30 a.m.", 0, 15, 30 },
+		{ "23:59:59", 23, 59, 59 },
+		{ "2026-10-19T07:30:00Z", 7, 30, 0 },
+		{ "2024-02-29 23:00+05:30", 23, 0, 0 },
+		{ "2024-02-29 23:00+0530", 23, 0, 0 },
+		{ "2024-01-01 ", 0, 0, 0 }
+	};
+	char const * invalid[] = { "", "7", "24:00", "7:60", "13pm", "0am",
+		"7:5", "7:30:60", "2026-02-29", "2026-13-01", "2026-10-19T7:30",
+		"2026-10-19T07:30+24:00", "07:30Z", "7:30 xm", "123:00",
+		"2026-10-19T07:30+05:", "2026-10-19T07:30+05:3",
+		"2026-10-19T07:30+053", "2026-10-19T07:30+05300",
+		"2026-10-19T07:30+05:30:", "2026-10-19T", "2026-10-19 T" };
+	ClockParserTime t;
+	int64_t utc;
+	size_t i;
+
+	for(i = 0; i < sizeof(valid) / sizeof(*valid); i++)
+		if(clockparser_time(valid[i].string, &t) != 0
+				|| t.hour != valid[i].hour
+				|| t.minute != valid[i].minute
+				|| t.second != valid[i].second)
+			return _error(valid[i].string, "invalid time");
+	for(i = 0; i < sizeof(invalid) / sizeof(*invalid); i++)
+		if(clockparser_time(invalid[i], &t) == 0)
+			return _error(invalid[i], "should not parse");
+	if(clockparser_time("2026-10-19T07:30:00+02:00", &t) != 0
+			|| clockparser_time_to_utc(&t, &utc) != 0
+			|| utc != 1792387800)
+		return _error("2026-10-19T07:30:00+02:00", "invalid UTC time");
+	return 0;
+}
+
+
+/* error */
+static int _error(char const * string, char const * message)
+{
+	fprintf(stderr, "%s: %s: %s\n", PROGNAME, string, message);
+	return 2;
+}
+
+
+/* main */
+int main(void)
+{
+	int ret = 0;
+
+	clockparser_init();
+	srand(42);
+	ret |= _times();
+	ret |= _durations();
+	ret |= _fuzz_times();
+	ret |= _fuzz_durations();
+	ret |= _fuzz_garbage();
+	ret |= _benchmark();
+	return ret;
+}
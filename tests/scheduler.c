@@ -0,0 +1,169 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdio.h>
+#include "../src/scheduler.c"
+
+#ifndef PROGNAME
+# define PROGNAME	"scheduler"
+#endif
+
+
+/* private */
+/* types */
+typedef struct _Simulation
+{
+	int64_t * tolerances;
+	size_t fired;
+	size_t errors;
+} Simulation;
+
+
+/* constants */
+#define ENTRIES		1000
+#define DURATION	(24 * 3600 * 1000)	/* one day (ms) */
+#define TOLERANCE	(5 * 60 * 1000)		/* up to five minutes */
+
+
+/* prototypes */
+static int _scheduler(unsigned int seed);
+static int _scheduler_positions(ClockScheduler * scheduler,
+		int64_t const * deadlines, size_t count);
+
+static void _scheduler_on_fire(void * data, unsigned int id,
+		int64_t deadline, int64_t now);
+
+
+/* functions */
+/* scheduler */
+static int _scheduler(unsigned int seed)
+{
+	ClockScheduler * scheduler;
+	Simulation simulation;
+	int64_t tolerances[ENTRIES];
+	int64_t deadlines[ENTRIES];
+	ClockSchedulerStats stats;
+	int64_t when;
+	int64_t slack;
+	size_t before;
+	size_t i;
+	size_t j;
+
+	if((scheduler = clockscheduler_new()) == NULL)
+		return 2;
+	srand(seed);
+	for(i = 0; i < ENTRIES; i++)
+	{
+		deadlines[i] = rand() % DURATION;
+		tolerances[i] = rand() % (TOLERANCE + 1);
+		if(clockscheduler_set(scheduler, i, deadlines[i],
+					tolerances[i]) != 0)
+		{
+			clockscheduler_delete(scheduler);
+			return 2;
+		}
+	}
+	/* re-schedule a few entries */
+	for(i = 0; i < ENTRIES; i += 7)
+	{
+		deadlines[i] = rand() % DURATION;
+		clockscheduler_set(scheduler, i, deadlines[i], tolerances[i]);
+	}
+	if(_scheduler_positions(scheduler, deadlines, ENTRIES) != 0)
+	{
+		clockscheduler_delete(scheduler);
+		return 2;
+	}
+	/* without coalescing, every distinct deadline wakes up */
+	for(i = 0, before = 0; i < ENTRIES; i++)
+	{
+		for(j = 0; j < i && deadlines[j] != deadlines[i]; j++);
+		if(j == i)
+			before++;
+	}
+	memset(&simulation, 0, sizeof(simulation));
+	simulation.tolerances = tolerances;
+	while(clockscheduler_get_wakeup(scheduler, &when, &slack) == 0)
+		/* emulate timer slack anywhere within the window */
+		clockscheduler_fire(scheduler, when + rand() % (slack + 1),
+				_scheduler_on_fire, &simulation);
+	clockscheduler_get_stats(scheduler, &stats);
+	clockscheduler_delete(scheduler);
+	printf("%s: seed %u: %zu entries, %zu errors\n", PROGNAME, seed,
+			simulation.fired, simulation.errors);
+	printf("%s: wakeups per hour: %.1f before, %.1f after coalescing\n",
+			PROGNAME, (double)before * 3600000 / DURATION,
+			(double)stats.wakeups * 3600000 / DURATION);
+	if(simulation.fired != ENTRIES || simulation.errors != 0
+			|| stats.fired != ENTRIES || stats.wakeups >= before
+			|| stats.empty != 0)
+		return 2;
+	return 0;
+}
+
+static int _scheduler_positions(ClockScheduler * scheduler,
+		int64_t const * deadlines, size_t count)
+{
+	size_t i;
+	size_t j;
+	size_t expected;
+	size_t position;
+
+	for(i = 0; i < count; i++)
+	{
+		for(j = 0, expected = 0; j < count; j++)
+			if(deadlines[j] < deadlines[i]
+					|| (deadlines[j] == deadlines[i]
+						&& j < i))
+				expected++;
+		if(clockscheduler_get_position(scheduler, i, &position) != 0
+				|| position != expected)
+		{
+			fprintf(stderr, "%s: %zu: Invalid position\n", PROGNAME,
+					i);
+			return 2;
+		}
+	}
+	return 0;
+}
+
+static void _scheduler_on_fire(void * data, unsigned int id,
+		int64_t deadline, int64_t now)
+{
+	Simulation * simulation = data;
+
+	simulation->fired++;
+	if(now < deadline || now > deadline + simulation->tolerances[id])
+	{
+		fprintf(stderr, "%s: %u: Fired outside of its window\n",
+				PROGNAME, id);
+		simulation->errors++;
+	}
+}
+
+
+/* main */
+int main(void)
+{
+	int ret = 0;
+	unsigned int seed;
+
+	for(seed = 1; seed <= 4; seed++)
+		if(_scheduler(seed) != 0)
+			ret = 2;
+	return ret;
+}
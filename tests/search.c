@@ -0,0 +1,292 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdio.h>
+#include <time.h>
+#include "../src/search.c"
+
+#ifndef PROGNAME
+# define PROGNAME	"search"
+#endif
+
+
+/* private */
+/* constants */
+#define ROWS		100000
+
+
+/* variables */
+static char _titles[ROWS][32];
+static char * _folded[ROWS];				/* cached */
+static unsigned char _visible[ROWS];
+static int _everything = 1;			/* after an empty query */
+
+
+/* prototypes */
+static int _search(ClockSearch * search, char const * query);
+static int _changes(ClockSearch * search, unsigned char const * visible,
+		size_t * changes);
+static size_t _match(char const * query, unsigned char * visible);
+static size_t _naive(char const * query);
+static double _now(void);
+static void _title(ClockSearch * search, size_t i, char const * title);
+
+
+/* functions */
+/* search */
+static int _search(ClockSearch * search, char const * query)
+{
+	char const * p;
+	double before;
+	double indexed = 0.0;
+	double naive;
+	size_t count = 0;
+	size_t expected;
+	size_t changes;
+	size_t first = 0;
+	size_t most = 0;
+	size_t keystrokes = 0;
+	size_t len;
+	char buf[CLOCKSEARCH_QUERY_MAX];
+	char * q;
+
+	/* one query per keystroke, and per character */
+	for(p = query; *p != '\0'; keystrokes++)
+	{
+		for(p++; (*p & 0xc0) == 0x80; p++);
+		len = p - query;
+		snprintf(buf, sizeof(buf), "%.*s", (int)len, query);
+		/* everything the view needs to be updated */
+		before = _now();
+		if(clocksearch_query(search, buf, &count) != 0
+				|| _changes(search, NULL, NULL) != 0)
+			return 2;
+		indexed += _now() - before;
+		q = _clocksearch_fold(buf);
+		expected = _match(q, NULL);
+		/* only the rows changing visibility are updated */
+		changes = 0;
+		if(count != expected
+				|| _changes(search, _visible, &changes) != 0)
+		{
+			fprintf(stderr, "%s: %s: %zu results, expected %zu%s\n",
+					PROGNAME, buf, count, expected,
+					(count == expected)
+					? ", invalid changes" : "");
+			g_free(q);
+			return 2;
+		}
+		if(keystrokes == 0)
+			first = changes;
+		else if(changes > most)
+			most = changes;
+		_match(q, _visible);
+		_everything = (q[0] == '\0');
+		g_free(q);
+	}
+	/* only compared for the complete query */
+	before = _now();
+	expected = _naive(query);
+	naive = _now() - before;
+	if(count != expected)
+	{
+		fprintf(stderr, "%s: %s: %zu results, expected %zu\n",
+				PROGNAME, query, count, expected);
+		return 2;
+	}
+	printf("%s: \"%s\": %zu results, %.3f ms per keystroke (naive %.3f),"
+			" %zu then at most %zu rows updated\n", PROGNAME,
+			query, count, indexed * 1000.0 / keystrokes,
+			naive * 1000.0, first, most);
+	return 0;
+}
+
+
+/* changes */
+/* checks the changes against the rows visible before the last query */
+static int _changes(ClockSearch * search, unsigned char const * visible,
+		size_t * changes)
+{
+	static unsigned char changed[ROWS];
+	unsigned int const * ids = NULL;
+	size_t count = 0;
+	size_t i;
+	int ret = 0;
+
+	if(clocksearch_get_changes(search, &ids, &count) != 0)
+	{
+		if(visible == NULL)
+			return 0;
+		*changes += ROWS;
+		/* only when every row may change */
+		return (_everything || search->query[0] == '\0') ? 0 : -1;
+	}
+	if(visible == NULL)
+		return 0;
+	*changes += count;
+	memset(changed, 0, sizeof(changed));
+	for(i = 0; i < count; i++)
+		if(ids[i] >= ROWS || changed[ids[i]]++ != 0)
+			ret = -1;
+	/* the rows deleted do not matter */
+	for(i = 0; i < ROWS; i++)
+		if(_folded[i] != NULL && (visible[i]
+					!= clocksearch_get_match(search, i))
+				!= changed[i])
+			ret = -1;
+	return ret;
+}
+
+
+/* match */
+static size_t _match(char const * query, unsigned char * visible)
+{
+	size_t ret = 0;
+	size_t i;
+	int m;
+
+	for(i = 0; i < ROWS; i++)
+	{
+		m = (_folded[i] != NULL && strstr(_folded[i], query) != NULL);
+		if(visible != NULL)
+			visible[i] = m;
+		ret += m;
+	}
+	return ret;
+}
+
+
+/* naive */
+static size_t _naive(char const * query)
+{
+	char * q;
+	char * title;
+	size_t ret = 0;
+	size_t i;
+
+	/* fold and compare every row, as a model filter would */
+	q = _clocksearch_fold(query);
+	for(i = 0; i < ROWS; i++)
+	{
+		if(_titles[i][0] == '\0')
+			continue;
+		title = _clocksearch_fold(_titles[i]);
+		if(strstr(title, q) != NULL)
+			ret++;
+		g_free(title);
+	}
+	g_free(q);
+	return ret;
+}
+
+
+/* now */
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+/* title */
+static void _title(ClockSearch * search, size_t i, char const * title)
+{
+	snprintf(_titles[i], sizeof(_titles[i]), "%s", title);
+	g_free(_folded[i]);
+	_folded[i] = NULL;
+	if(title[0] == '\0')
+	{
+		clocksearch_unset(search, i);
+		return;
+	}
+	_folded[i] = _clocksearch_fold(title);
+	clocksearch_set(search, i, title);
+}
+
+
+/* main */
+int main(void)
+{
+	char const * words[] = { "Wake up", "Meeting", "Laundry", "Lunch",
+		"Medication", "Standup", "Oven", "Call Bob", "Backup",
+		"School", "Gym", "Tea", "R\xc3\xa9veil", "\xc3\x89T\xc3\x89",
+		"Caf\xc3\xa9", "CAFE\xcc\x81", "\xef\xac\x81ka" };
+	const size_t words_cnt = sizeof(words) / sizeof(*words);
+	char const * queries[] = { "medication 4242", "standup", "tea 9",
+		"call bob 1234", "zzz", "R\xc3\x89VEIL 1", "\xc3\xa9t\xc3\xa9",
+		"caf\xc3\xa9 7", "fika" };
+	ClockSearch * search;
+	char buf[sizeof(*_titles)];
+	size_t i;
+	int ret = 0;
+
+	if((search = clocksearch_new()) == NULL)
+		return 2;
+	srand(42);
+	for(i = 0; i < ROWS; i++)
+	{
+		snprintf(buf, sizeof(buf), "%s %u", words[rand() % words_cnt],
+				rand() % 100000);
+		_title(search, i, buf);
+	}
+	_match("", _visible);
+	for(i = 0; i < sizeof(queries) / sizeof(*queries); i++)
+		ret |= _search(search, queries[i]);
+	/* update the index incrementally */
+	for(i = 0; i < ROWS; i += 3)
+	{
+		snprintf(buf, sizeof(buf), "Renamed %zu", i);
+		_title(search, i, buf);
+	}
+	for(i = 1; i < ROWS; i += 7)
+		_title(search, i, "");
+	/* a new row shows up whatever the query, until the next one */
+	if(clocksearch_query(search, "standup", NULL) != 0)
+		ret |= 2;
+	_title(search, 1, "Alarm");
+	if(clocksearch_get_match(search, 1) != 1)
+	{
+		fprintf(stderr, "%s: %s: New row hidden\n", PROGNAME,
+				_titles[1]);
+		ret |= 2;
+	}
+	_match(search->query, _visible);
+	_visible[1] = 1;
+	if(clocksearch_query(search, "standup", NULL) != 0
+			|| clocksearch_get_match(search, 1) != 0
+			|| _changes(search, _visible, &i) != 0)
+	{
+		fprintf(stderr, "%s: %s: New row not filtered\n", PROGNAME,
+				_titles[1]);
+		ret |= 2;
+	}
+	/* as the view would on such edits */
+	_match(search->query, _visible);
+	for(i = 0; i < sizeof(queries) / sizeof(*queries); i++)
+		ret |= _search(search, queries[i]);
+	ret |= _search(search, "renamed 99");
+	/* every row shows up again */
+	if(clocksearch_query(search, "", &i) != 0 || i != _match("", NULL)
+			|| _changes(search, _visible, &i) != 0)
+		ret |= 2;
+	clocksearch_delete(search);
+	for(i = 0; i < ROWS; i++)
+		g_free(_folded[i]);
+	return ret;
+}
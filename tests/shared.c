@@ -0,0 +1,334 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include "../src/shared.c"
+
+#ifndef PROGNAME
+# define PROGNAME	"shared"
+#endif
+
+
+/* private */
+/* types */
+typedef struct _Reader
+{
+	ClockSharedReader * reader;
+	size_t reads;
+	size_t polls;
+	size_t errors;
+} Reader;
+
+
+/* constants */
+#define READERS		8
+#define UPDATES		200000
+#define BENCHMARK	10000000
+
+
+/* variables */
+static int _stop = 0;
+
+
+/* prototypes */
+static int _benchmark(char const * name);
+static int _check(ClockSharedTable const * table);
+static void _fill(ClockSharedTable * table, uint32_t k);
+static int _hammer(char const * name);
+static double _now(void);
+static int _permissions(char const * name);
+static int _writers(char const * name);
+
+static void * _reader(void * data);
+
+
+/* functions */
+/* benchmark */
+static int _benchmark(char const * name)
+{
+	ClockSharedReader * reader;
+	ClockSharedTable table;
+	double before;
+	double read;
+	double poll;
+	uint32_t generation = 0;
+	size_t i;
+	size_t errors = 0;
+
+	if((reader = clockshared_open(name)) == NULL)
+		return 2;
+	before = _now();
+	for(i = 0; i < BENCHMARK; i++)
+		if(clockshared_read(reader, &table) != 0
+				|| table.generation == 0)
+			errors++;
+	read = _now() - before;
+	before = _now();
+	for(i = 0; i < BENCHMARK; i++)
+		generation += clockshared_get_generation(reader);
+	poll = _now() - before;
+	clockshared_close(reader);
+	printf("%s: %.1f ns per snapshot, %.1f ns per poll (%u)\n", PROGNAME,
+			read * 1000000000.0 / BENCHMARK,
+			poll * 1000000000.0 / BENCHMARK, generation != 0);
+	return (errors == 0) ? 0 : 2;
+}
+
+
+/* check */
+/* returns 0 if the snapshot is consistent */
+static int _check(ClockSharedTable const * table)
+{
+	ClockSharedTable expected;
+
+	_fill(&expected, table->generation);
+	expected.generation = table->generation;
+	return memcmp(table, &expected, sizeof(expected)) == 0 ? 0 : -1;
+}
+
+
+/* fill */
+static void _fill(ClockSharedTable * table, uint32_t k)
+{
+	char buf[CLOCKSHARED_TITLE * 2];
+	size_t i;
+
+	memset(table, 0, sizeof(*table));
+	table->gmtoff = k % 86400;
+	table->offset = k;
+	table->time = (int64_t)k * 3;
+	table->count = k % (CLOCKSHARED_DEADLINES + 1);
+	for(i = 0; i < table->count; i++)
+	{
+		table->deadlines[i].deadline = (int64_t)k * 1000 + i;
+		table->deadlines[i].id = k + i;
+		table->deadlines[i].flags = i & CSF_TIMER;
+		/* long enough to be truncated */
+		snprintf(buf, sizeof(buf), "R\xc3\xa9veil %u/%zu %0*u", k, i,
+				(int)(CLOCKSHARED_TITLE - 16), k);
+		clockshared_set_title(&table->deadlines[i], buf);
+	}
+}
+
+
+/* hammer */
+static int _hammer(char const * name)
+{
+	ClockShared * shared;
+	ClockSharedTable table;
+	pthread_t threads[READERS];
+	Reader readers[READERS];
+	size_t reads = 0;
+	size_t polls = 0;
+	size_t errors = 0;
+	uint32_t k;
+	size_t i;
+	double before;
+	double elapsed;
+
+	if((shared = clockshared_new(name)) == NULL)
+		return 2;
+	_fill(&table, 1);
+	clockshared_update(shared, &table);
+	memset(readers, 0, sizeof(readers));
+	for(i = 0; i < READERS; i++)
+		if((readers[i].reader = clockshared_open(name)) == NULL
+				|| pthread_create(&threads[i], NULL, _reader,
+					&readers[i]) != 0)
+		{
+			clockshared_delete(shared);
+			return 2;
+		}
+	/* the generation matches the contents */
+	before = _now();
+	for(k = 2; k <= UPDATES; k++)
+	{
+		_fill(&table, k);
+		clockshared_update(shared, &table);
+		if(table.generation != k)
+			errors++;
+	}
+	elapsed = _now() - before;
+	__atomic_store_n(&_stop, 1, __ATOMIC_RELAXED);
+	for(i = 0; i < READERS; i++)
+	{
+		pthread_join(threads[i], NULL);
+		clockshared_close(readers[i].reader);
+		reads += readers[i].reads;
+		polls += readers[i].polls;
+		errors += readers[i].errors;
+	}
+	printf("%s: %u updates in %.3fs, %u readers: %zu snapshots, %zu polls"
+			", %zu errors\n", PROGNAME, UPDATES, elapsed, READERS,
+			reads, polls, errors);
+	if(errors == 0)
+		errors = _benchmark(name);
+	clockshared_delete(shared);
+	return (errors == 0) ? 0 : 2;
+}
+
+
+/* now */
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+/* permissions */
+/* the table of another user, or open to others, is refused */
+static int _permissions(char const * name)
+{
+	int fd;
+	int ret = 0;
+	ClockShared * shared;
+	ClockSharedReader * reader;
+
+	if((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)) < 0)
+		return 2;
+	if(fchmod(fd, 0644) != 0
+			|| ftruncate(fd, sizeof(ClockSharedPage)) != 0)
+		ret = 2;
+	else if((shared = clockshared_new(name)) != NULL)
+	{
+		fprintf(stderr, "%s: %s: Writable\n", PROGNAME, name);
+		clockshared_delete(shared);
+		ret = 2;
+	}
+	else if((reader = clockshared_open(name)) != NULL)
+	{
+		fprintf(stderr, "%s: %s: Readable\n", PROGNAME, name);
+		clockshared_close(reader);
+		ret = 2;
+	}
+	close(fd);
+	shm_unlink(name);
+	return ret;
+}
+
+
+/* reader */
+static void * _reader(void * data)
+{
+	Reader * reader = data;
+	ClockSharedTable table;
+	uint32_t last = 0;
+	uint32_t generation;
+
+	while(__atomic_load_n(&_stop, __ATOMIC_RELAXED) == 0)
+	{
+		if((generation = clockshared_get_generation(reader->reader))
+				== last)
+		{
+			reader->polls++;
+			continue;
+		}
+		if(clockshared_read(reader->reader, &table) != 0
+				|| table.generation < last
+				|| _check(&table) != 0)
+		{
+			reader->errors++;
+			continue;
+		}
+		last = table.generation;
+		reader->reads++;
+	}
+	return NULL;
+}
+
+
+/* writers */
+/* one at a time, each unlinking its own table */
+static int _writers(char const * name)
+{
+	ClockShared * shared;
+	ClockShared * second;
+	ClockSharedReader * reader;
+	ClockSharedTable table;
+	uint32_t generation;
+	int ret = 0;
+
+	if((shared = clockshared_new(name)) == NULL)
+		return 2;
+	_fill(&table, 1);
+	clockshared_update(shared, &table);
+	if((second = clockshared_new(name)) != NULL)
+	{
+		fprintf(stderr, "%s: %s: Second writer\n", PROGNAME, name);
+		clockshared_delete(second);
+		ret = 2;
+	}
+	else if((reader = clockshared_open(name)) == NULL)
+	{
+		fprintf(stderr, "%s: %s: Unlinked by the second writer\n",
+				PROGNAME, name);
+		ret = 2;
+	}
+	else
+	{
+		/* the readers are told when the writer is gone */
+		generation = clockshared_get_generation(reader);
+		clockshared_delete(shared);
+		shared = NULL;
+		if(clockshared_get_generation(reader) == generation
+				|| clockshared_read(reader, &table) == 0
+				|| errno != ESTALE)
+		{
+			fprintf(stderr, "%s: %s: Not told when closed\n",
+					PROGNAME, name);
+			ret = 2;
+		}
+		clockshared_close(reader);
+	}
+	if(shared != NULL)
+		clockshared_delete(shared);
+	if((reader = clockshared_open(name)) != NULL)
+	{
+		fprintf(stderr, "%s: %s: Not unlinked\n", PROGNAME, name);
+		clockshared_close(reader);
+		ret = 2;
+	}
+	/* the next writer may start */
+	if(ret != 0 || (shared = clockshared_new(name)) == NULL)
+		return 2;
+	clockshared_delete(shared);
+	return 0;
+}
+
+
+/* main */
+int main(void)
+{
+	char name[64];
+	ClockSharedDeadline deadline;
+
+	/* multi-byte characters are kept whole */
+	clockshared_set_title(&deadline, "0123456789012345678901234567890123"
+			"456789012345\xc3\xa9");
+	if(strlen(deadline.title) != CLOCKSHARED_TITLE - 2)
+		return 2;
+	snprintf(name, sizeof(name), "/DeforaOS-Clock-test-%lu",
+			(unsigned long)getpid());
+	if(_permissions(name) != 0 || _writers(name) != 0)
+		return 2;
+	return _hammer(name);
+}
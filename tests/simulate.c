@@ -0,0 +1,506 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Accessories */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <inttypes.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "../src/engine.c"
+#include "../src/scheduler.c"
+#include "../src/source.c"
+
+#ifndef PROGNAME
+# define PROGNAME	"simulate"
+#endif
+
+
+/* private */
+/* types */
+typedef enum _SimulationType
+{
+	ST_ALARM = 0,				/* daily */
+	ST_DATED,
+	ST_TIMER				/* started during the week */
+} SimulationType;
+
+typedef struct _SimulationEntry
+{
+	SimulationType type;
+	int seconds;				/* time of day or duration */
+	int64_t tolerance;
+	size_t fired;
+
+	/* daily alarms */
+	int64_t last;
+	int64_t next;				/* expected */
+} SimulationEntry;
+
+typedef struct _SimulationEvent
+{
+	char const * name;
+	int64_t monotonic;			/* since the start */
+	int64_t duration;
+	int suspend;				/* or a step */
+} SimulationEvent;
+
+typedef struct _SimulationStart
+{
+	int64_t monotonic;
+	unsigned int id;
+} SimulationStart;
+
+typedef struct _Simulation
+{
+	char const * name;
+	ClockSource * source;
+	ClockEngine * engine;
+	SimulationEntry * entries;
+	FILE * trace;
+
+	/* for the expected occurrences */
+	ClockSource * scratch;
+	int64_t end;
+
+	/* the last disturbance, in wall-clock time */
+	int64_t from;
+	int64_t to;
+
+	/* results */
+	size_t fired;
+	size_t errors;
+	int64_t lateness;			/* maximum */
+	size_t late;				/* skipped by a disturbance */
+	int64_t late_max;			/* after the disturbance */
+} Simulation;
+
+
+/* constants */
+#define ENTRIES		10000
+#define DAY		(24 * 3600 * 1000LL)
+#define TIMEZONE	"CET-1CEST,M3.5.0,M10.5.0/3"
+
+/* the next tick of the clock, then the second of GLib */
+#define REARM		2000
+
+
+/* variables */
+static const SimulationEvent _events[] =
+{
+	{ "step", DAY + 3 * 3600000, 5 * 60000, 0 },
+	{ "step", 2 * DAY + 10 * 3600000, -10 * 60000, 0 },
+	{ "step", 2 * DAY + 20 * 3600000, -DAY - 3 * 3600000, 0 },
+	{ "suspend", 3 * DAY + 13 * 3600000, 30 * 60000, 1 },
+	{ "step", 4 * DAY + 9 * 3600000, 3600000, 0 },
+	{ "suspend", 5 * DAY + 3600000, 8 * 3600000, 1 },
+	{ "step", 6 * DAY + 12 * 3600000, -3600000, 0 }
+};
+
+
+/* prototypes */
+static int _simulate(char const * name, int year, int month, int day,
+		FILE * trace);
+static int64_t _simulate_align(int64_t monotonic, int64_t phase);
+static int64_t _simulate_arm(Simulation * simulation, int64_t phase);
+static int _simulate_check(Simulation * simulation);
+static int _simulate_compare(void const * a, void const * b);
+static int _simulate_next(Simulation * simulation, SimulationEntry * entry,
+		int64_t now);
+static void _simulate_on_event(void * data, unsigned int id,
+		ClockEngineEvent event, int64_t deadline, int64_t now);
+
+static int _usage(void);
+
+
+/* functions */
+/* simulate */
+static int _simulate(char const * name, int year, int month, int day,
+		FILE * trace)
+{
+	Simulation simulation;
+	SimulationEntry * entry;
+	SimulationStart * starts;
+	size_t starts_cnt = 0;
+	size_t started = 0;
+	struct tm tm;
+	struct timespec before;
+	struct timespec after;
+	int64_t start;
+	int64_t end;
+	int64_t deadline;
+	int64_t armed;
+	int64_t tick = INT64_MAX;
+	int64_t phase;
+	int64_t next;
+	int64_t expected;
+	ClockSchedulerStats stats;
+	size_t event = 0;
+	size_t i;
+	double elapsed;
+	int ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	memset(&simulation, 0, sizeof(simulation));
+	simulation.name = name;
+	simulation.trace = trace;
+	/* a week, from midnight in local time */
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = year - 1900;
+	tm.tm_mon = month - 1;
+	tm.tm_mday = day;
+	tm.tm_isdst = -1;
+	start = (int64_t)mktime(&tm) * 1000;
+	tm.tm_mday += 7;
+	tm.tm_isdst = -1;
+	end = (int64_t)mktime(&tm) * 1000;
+	simulation.end = end;
+	if((simulation.source = clocksource_new_virtual(start)) == NULL
+			|| (simulation.scratch = clocksource_new_virtual(start))
+			== NULL
+			|| (simulation.engine = clockengine_new(
+					simulation.source, _simulate_on_event,
+					&simulation)) == NULL
+			|| (simulation.entries = calloc(ENTRIES,
+					sizeof(*simulation.entries))) == NULL
+			|| (starts = calloc(ENTRIES, sizeof(*starts))) == NULL)
+		return 2;
+	srand(42);
+	phase = rand() % 1000;
+	for(i = 0; i < ENTRIES; i++)
+	{
+		entry = &simulation.entries[i];
+		switch(rand() % 10)
+		{
+			case 0:
+				entry->type = ST_DATED;
+				deadline = start + 3600000 + (int64_t)rand()
+					% (end - start - 2 * 3600000);
+				entry->tolerance = (rand() % 61) * 1000;
+				if(clockengine_set_alarm(simulation.engine, i,
+							0, deadline,
+							entry->tolerance) != 0)
+					return 2;
+				break;
+			case 1: case 2: case 3: case 4:
+				/* started later, across the disturbances */
+				entry->type = ST_TIMER;
+				entry->seconds = 600 + rand() % (12 * 3600);
+				entry->tolerance = 1000;
+				starts[starts_cnt].monotonic = (int64_t)rand()
+					% (5 * DAY);
+				starts[starts_cnt++].id = i;
+				break;
+			default:
+				entry->type = ST_ALARM;
+				entry->seconds = 1 + rand() % (24 * 3600 - 1);
+				entry->tolerance = (rand() % 61) * 1000;
+				if(clockengine_set_alarm(simulation.engine, i,
+							entry->seconds, 0,
+							entry->tolerance) != 0
+						|| _simulate_next(&simulation,
+							entry, start) != 0)
+					return 2;
+				break;
+		}
+	}
+	qsort(starts, starts_cnt, sizeof(*starts), _simulate_compare);
+	/* advance from one event to the next */
+	armed = _simulate_arm(&simulation, phase);
+	for(;;)
+	{
+		next = armed;
+		if(tick < next)
+			next = tick;
+		if(event < sizeof(_events) / sizeof(*_events)
+				&& _events[event].monotonic < next)
+			next = _events[event].monotonic;
+		if(started < starts_cnt && starts[started].monotonic < next)
+			next = starts[started].monotonic;
+		/* until the end of the week */
+		if(next == INT64_MAX || clocksource_get_time(simulation.source)
+				+ next - clocksource_get_monotonic(
+					simulation.source) >= end)
+			break;
+		clocksource_advance(simulation.source, next
+				- clocksource_get_monotonic(simulation.source));
+		if(event < sizeof(_events) / sizeof(*_events)
+				&& next == _events[event].monotonic)
+		{
+			simulation.from = clocksource_get_time(
+					simulation.source);
+			if(_events[event].suspend)
+				clocksource_suspend(simulation.source,
+						_events[event].duration);
+			else
+				clocksource_set_time(simulation.source,
+						simulation.from
+						+ _events[event].duration);
+			simulation.to = clocksource_get_time(simulation.source);
+			/* stepped back: the days in between fire again, except
+			 * for the occurrence last fired */
+			for(i = 0; _events[event].duration < 0 && i < ENTRIES;
+					i++)
+			{
+				entry = &simulation.entries[i];
+				expected = entry->next;
+				if(entry->type != ST_ALARM
+						|| _simulate_next(&simulation,
+							entry, simulation.to)
+						!= 0)
+					continue;
+				if(entry->next == entry->last
+						|| entry->next > expected)
+					entry->next = expected;
+			}
+			event++;
+			/* the next tick of the clock, every second */
+			tick = _simulate_align(next + 1, phase);
+		}
+		else if(started < starts_cnt
+				&& next == starts[started].monotonic)
+		{
+			/* as if started by the user */
+			entry = &simulation.entries[starts[started].id];
+			if(clockengine_set_timer(simulation.engine,
+						starts[started++].id,
+						entry->seconds,
+						entry->tolerance) != 0)
+				simulation.errors++;
+			armed = _simulate_arm(&simulation, phase);
+		}
+		else if(next == tick)
+		{
+			/* as done by the clock */
+			tick = INT64_MAX;
+			if(clockengine_sync(simulation.engine) != 0)
+				armed = _simulate_arm(&simulation, phase);
+		}
+		else
+		{
+			clockengine_fire(simulation.engine);
+			armed = _simulate_arm(&simulation, phase);
+		}
+	}
+	clockengine_get_stats(simulation.engine, &stats);
+	ret = _simulate_check(&simulation);
+	clock_gettime(CLOCK_MONOTONIC, &after);
+	elapsed = (after.tv_sec - before.tv_sec)
+		+ (after.tv_nsec - before.tv_nsec) / 1000000000.0;
+	printf("%s: %s: %u entries fired %zu times in %" PRIu64 " wakeups\n",
+			PROGNAME, name, ENTRIES, simulation.fired,
+			stats.wakeups);
+	printf("%s: %s: lateness at most %" PRId64 " ms, or %" PRId64
+			" ms after a disturbance for %zu\n", PROGNAME, name,
+			simulation.lateness, simulation.late_max,
+			simulation.late);
+	printf("%s: %s: %zu errors in %.3fs\n", PROGNAME, name,
+			simulation.errors, elapsed);
+	if(elapsed >= 1.0)
+	{
+		fprintf(stderr, "%s: %s: Too slow\n", PROGNAME, name);
+		ret = 2;
+	}
+	free(starts);
+	free(simulation.entries);
+	clocksource_delete(simulation.scratch);
+	clockengine_delete(simulation.engine);
+	clocksource_delete(simulation.source);
+	return ret;
+}
+
+
+/* simulate_align */
+/* GLib fires the timeouts in seconds on a phase of its own */
+static int64_t _simulate_align(int64_t monotonic, int64_t phase)
+{
+	int64_t r;
+
+	if((r = ((monotonic - phase) % 1000 + 1000) % 1000) != 0)
+		monotonic += 1000 - r;
+	return monotonic;
+}
+
+
+/* simulate_arm */
+/* returns the monotonic time of the next wakeup, as set by the clock */
+static int64_t _simulate_arm(Simulation * simulation, int64_t phase)
+{
+	int64_t delay;
+	int64_t slack;
+	int64_t monotonic;
+
+	if(clockengine_get_wakeup(simulation->engine, &delay, &slack) != 0)
+		return INT64_MAX;
+	monotonic = clocksource_get_monotonic(simulation->source);
+	if(slack < 2000)
+		return monotonic + delay;
+	return _simulate_align(monotonic + (delay + 999) / 1000 * 1000, phase);
+}
+
+
+/* simulate_check */
+static int _simulate_check(Simulation * simulation)
+{
+	SimulationEntry * entry;
+	size_t i;
+
+	for(i = 0; i < ENTRIES; i++)
+	{
+		entry = &simulation->entries[i];
+		/* every day, and the timers are not restarted when fired */
+		if((entry->type == ST_ALARM && (entry->fired < 7
+						|| entry->next
+						+ entry->tolerance + REARM
+						< simulation->end))
+				|| (entry->type != ST_ALARM
+					&& entry->fired != 1))
+		{
+			fprintf(stderr, "%s: %s: %zu: Fired %zu times\n",
+					PROGNAME, simulation->name, i,
+					entry->fired);
+			simulation->errors++;
+		}
+	}
+	return (simulation->errors == 0) ? 0 : 2;
+}
+
+
+/* simulate_compare */
+static int _simulate_compare(void const * a, void const * b)
+{
+	SimulationStart const * sa = a;
+	SimulationStart const * sb = b;
+
+	if(sa->monotonic != sb->monotonic)
+		return (sa->monotonic < sb->monotonic) ? -1 : 1;
+	return (sa->id < sb->id) ? -1 : (sa->id > sb->id);
+}
+
+
+/* simulate_next */
+/* the occurrence expected after the time given */
+static int _simulate_next(Simulation * simulation, SimulationEntry * entry,
+		int64_t now)
+{
+	if(clocksource_set_time(simulation->scratch, now) != 0)
+		return -1;
+	return clocksource_daily(simulation->scratch, entry->seconds,
+			entry->last, &entry->next);
+}
+
+
+/* simulate_on_event */
+static void _simulate_on_event(void * data, unsigned int id,
+		ClockEngineEvent event, int64_t deadline, int64_t now)
+{
+	Simulation * simulation = data;
+	SimulationEntry * entry = &simulation->entries[id];
+	int64_t lateness = now - deadline;
+	int64_t bound = entry->tolerance;
+	char const * types[] = { "alarm", "dated", "timer" };
+
+	if(event != CEE_FIRED)
+		return;
+	entry->fired++;
+	simulation->fired++;
+	if(simulation->trace != NULL)
+		fprintf(simulation->trace, "%s\t%" PRId64 "\t%u\t%s\t%" PRId64
+				"\t%" PRId64 "\n", simulation->name, now, id,
+				types[entry->type], deadline, lateness);
+	/* the timers follow the monotonic time: always within their
+	 * tolerance; the alarms still pending when stepping forward or
+	 * suspending fire once the clock noticed it */
+	if(entry->type != ST_TIMER
+			&& deadline + entry->tolerance > simulation->from
+			&& deadline <= simulation->to && lateness > bound)
+	{
+		if(simulation->to + REARM - deadline > bound)
+			bound = simulation->to + REARM - deadline;
+		simulation->late++;
+		if(now - simulation->to > simulation->late_max)
+			simulation->late_max = now - simulation->to;
+	}
+	else if(lateness > simulation->lateness)
+		simulation->lateness = lateness;
+	if(lateness < 0 || lateness > bound)
+	{
+		fprintf(stderr, "%s: %s: %u: Fired %" PRId64 " ms late\n",
+				PROGNAME, simulation->name, id, lateness);
+		simulation->errors++;
+	}
+	if(entry->type != ST_ALARM)
+		return;
+	/* once per local day, none skipped */
+	if(deadline != entry->next)
+	{
+		fprintf(stderr, "%s: %s: %u: Fired for %" PRId64 " instead of %"
+				PRId64 "\n", PROGNAME, simulation->name, id,
+				deadline, entry->next);
+		simulation->errors++;
+	}
+	entry->last = deadline;
+	if(_simulate_next(simulation, entry, now) != 0)
+		simulation->errors++;
+}
+
+
+/* usage */
+static int _usage(void)
+{
+	fprintf(stderr, "Usage: %s [-o trace]\n", PROGNAME);
+	return 1;
+}
+
+
+/* main */
+int main(int argc, char * argv[])
+{
+	int o;
+	char const * filename = NULL;
+	FILE * trace = NULL;
+	int ret = 0;
+
+	while((o = getopt(argc, argv, "o:")) != -1)
+		switch(o)
+		{
+			case 'o':
+				filename = optarg;
+				break;
+			default:
+				return _usage();
+		}
+	if(optind != argc)
+		return _usage();
+	if(filename != NULL && (trace = fopen(filename, "w")) == NULL)
+	{
+		perror(filename);
+		return 2;
+	}
+	if(trace != NULL)
+		fprintf(trace, "# scenario\ttime\tid\ttype\tdeadline"
+				"\tlateness\n");
+	/* the days are not all of 24 hours */
+	setenv("TZ", TIMEZONE, 1);
+	tzset();
+	ret |= _simulate("spring", 2026, 3, 26, trace);
+	ret |= _simulate("autumn", 2026, 10, 22, trace);
+	if(trace != NULL && fclose(trace) != 0)
+	{
+		perror(filename);
+		ret = 2;
+	}
+	return ret;
+}
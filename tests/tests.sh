@@ -0,0 +1,124 @@
+#!/bin/sh
+#$Id$
+#Copyright (c) 2026 Pierre Pronchery <khorben@defora.org>
+#
+#Redistribution and use in source and binary forms, with or without
+#modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+#THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+#AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+#IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+#DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+#FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+#DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+#SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+#CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+#OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#variables
+CONFIGSH="${0%/tests.sh}/../config.sh"
+PROGNAME="tests.sh"
+#executables
+DATE="date"
+MKDIR="mkdir -p"
+
+[ -f "$CONFIGSH" ] && . "$CONFIGSH"
+
+
+#functions
+#run
+_run()
+{
+	test="$1"
+	sep=
+
+	[ $# -eq 1 ] || sep=" "
+	shift
+	echo -n "$test:" 1>&2
+	(echo
+	echo "Testing: $test" "$@"
+	"${OBJDIR:-./}$test" "$@") 2>&1
+	res=$?
+	if [ $res -ne 0 ]; then
+		echo "Test: $test$sep$@: FAIL (error $res)"
+		echo " FAIL" 1>&2
+	else
+		echo "Test: $test$sep$@: PASS"
+		echo " PASS" 1>&2
+	fi
+	return $res
+}
+
+
+#test
+_test()
+{
+	_run "$@" >> "$target"
+	res=$?
+	[ $res -eq 0 ] || FAILED="$FAILED $test(error $res)"
+}
+
+
+#usage
+_usage()
+{
+	echo "Usage: $PROGNAME [-c][-P prefix] target..." 1>&2
+	return 1
+}
+
+
+#main
+clean=0
+while getopts "cO:P:" name; do
+	case "$name" in
+		c)
+			clean=1
+			;;
+		O)
+			export "${OPTARG%%=*}"="${OPTARG#*=}"
+			;;
+		P)
+			#XXX ignored for compatibility
+			;;
+		?)
+			_usage
+			exit $?
+			;;
+	esac
+done
+shift $((OPTIND - 1))
+if [ $# -ne 1 ]; then
+	_usage
+	exit $?
+fi
+target="$1"
+
+[ "$clean" -ne 0 ]			&& exit 0
+
+dirname="${target%/*}"
+if [ -n "$dirname" -a "$dirname" != "$target" ]; then
+	$MKDIR -- "$dirname"				|| exit 2
+fi
+$DATE > "$target"
+FAILED=
+echo "Performing tests:" 1>&2
+_test "drift" -f "${OBJDIR:-./}drift.ring"
+_test "parser"
+_test "scheduler"
+_test "search"
+_test "shared"
+_test "simulate" -o "${OBJDIR:-./}simulate.trace"
+if [ -n "$FAILED" ]; then
+	echo "Failed tests:$FAILED" 1>&2
+	exit 2
+fi
+echo "All tests completed" 1>&2